@@ -0,0 +1,168 @@
+// Сравнение ConcurrentMap с прежней реализацией (std::mutex и std::map
+// в каждом бакете) при параллельном накоплении по ключам.
+// Сборка из каталога benchmarks (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server concurrent_map_benchmark.cpp
+//       -o concurrent_map_benchmark -ltbb -lpthread
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "concurrent_map.h"
+
+using namespace std;
+
+// прежняя реализация для сравнения
+template <typename Key, typename Value>
+class LegacyConcurrentMap {
+private:
+    struct Bucket {
+        mutex bucket_mutex;
+        map<Key, Value> bucket_map;
+    };
+
+public:
+    struct Access {
+        lock_guard<mutex> guard;
+        Value& ref_to_value;
+
+        Access(const Key& key, Bucket& bucket)
+            : guard(bucket.bucket_mutex)
+            , ref_to_value(bucket.bucket_map[key]) {
+        }
+    };
+
+    explicit LegacyConcurrentMap(size_t bucket_count)
+        : buckets_(bucket_count) {
+    }
+
+    Access operator[](const Key& key) {
+        return { key, buckets_[static_cast<uint64_t>(key) % buckets_.size()] };
+    }
+
+    map<Key, Value> BuildOrdinaryMap() {
+        map<Key, Value> result;
+        for (auto& [bucket_mutex, bucket_map] : buckets_) {
+            lock_guard guard(bucket_mutex);
+            result.insert(bucket_map.begin(), bucket_map.end());
+        }
+        return result;
+    }
+
+private:
+    vector<Bucket> buckets_;
+};
+
+const size_t BUCKET_COUNT = 256;
+const size_t OPERATION_COUNT = 4000000;
+
+struct Measurement {
+    double update_ms = 0.0;
+    double build_ms = 0.0;
+    double checksum = 0.0;
+};
+
+double MillisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// каждый поток прибавляет к значениям своей доли ключей
+template <typename Map, typename Key, typename Build>
+Measurement Measure(const vector<vector<Key>>& thread_keys, Build build) {
+    Measurement result;
+    Map concurrent_map(BUCKET_COUNT);
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (const vector<Key>& keys : thread_keys) {
+        threads.emplace_back([&concurrent_map, &keys] {
+            for (const Key& key : keys) {
+                concurrent_map[key].ref_to_value += 1.0;
+            }
+            });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    result.update_ms = MillisecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    result.checksum = build(concurrent_map);
+    result.build_ms = MillisecondsSince(start);
+    return result;
+}
+
+// ключи с распределением Ципфа: несколько горячих ключей и длинный хвост
+vector<vector<int>> MakeKeys(size_t thread_count, int key_count, mt19937& generator) {
+    vector<vector<int>> thread_keys(thread_count);
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (vector<int>& keys : thread_keys) {
+        keys.reserve(OPERATION_COUNT / thread_count);
+        for (size_t i = 0; i < OPERATION_COUNT / thread_count; ++i) {
+            keys.push_back(static_cast<int>(pow(uniform(generator), 3.0) * key_count));
+        }
+    }
+    return thread_keys;
+}
+
+template <typename Container>
+double SumValues(const Container& container) {
+    double sum = 0.0;
+    for (const auto& [key, value] : container) {
+        sum += value;
+    }
+    return sum;
+}
+
+void RunCase(const string& name, size_t thread_count, int key_count, mt19937& generator) {
+    const vector<vector<int>> thread_keys = MakeKeys(thread_count, key_count, generator);
+    const Measurement legacy = Measure<LegacyConcurrentMap<int, double>>(thread_keys, [](auto& concurrent_map) {
+        return SumValues(concurrent_map.BuildOrdinaryMap());
+        });
+    const Measurement striped = Measure<ConcurrentMap<int, double>>(thread_keys, [](auto& concurrent_map) {
+        return SumValues(concurrent_map.BuildVector());
+        });
+    if (legacy.checksum != striped.checksum) {
+        cerr << "checksum mismatch in "s << name << endl;
+    }
+    cout << left << setw(24) << name << right << setw(8) << thread_count
+        << setw(12) << fixed << setprecision(1) << legacy.update_ms << setw(12) << striped.update_ms
+        << setw(12) << legacy.build_ms << setw(12) << striped.build_ms << endl;
+}
+
+// строковые ключи прежняя реализация не поддерживает
+void RunStringCase(size_t thread_count, int key_count, mt19937& generator) {
+    vector<vector<string>> thread_keys;
+    for (const vector<int>& keys : MakeKeys(thread_count, key_count, generator)) {
+        vector<string>& words = thread_keys.emplace_back();
+        words.reserve(keys.size());
+        for (const int key : keys) {
+            words.push_back("word"s + to_string(key));
+        }
+    }
+    const Measurement striped = Measure<ConcurrentMap<string, double>>(thread_keys, [](auto& concurrent_map) {
+        return SumValues(concurrent_map.BuildVector());
+        });
+    cout << left << setw(24) << "strings "s + to_string(key_count) << right << setw(8) << thread_count
+        << setw(12) << "-"s << setw(12) << fixed << setprecision(1) << striped.update_ms
+        << setw(12) << "-"s << setw(12) << striped.build_ms << endl;
+}
+
+int main() {
+    mt19937 generator(42);
+    // потоков не меньше 8, чтобы проверить блокировки и при вытеснении
+    const size_t max_threads = max(8u, thread::hardware_concurrency());
+    cout << left << setw(24) << "case"s << right << setw(8) << "threads"s
+        << setw(12) << "old add"s << setw(12) << "new add"s
+        << setw(12) << "old build"s << setw(12) << "new build"s << endl;
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        RunCase("hot 64 keys"s, thread_count, 64, generator);
+        RunCase("documents 100K"s, thread_count, 100000, generator);
+        RunCase("documents 1M"s, thread_count, 1000000, generator);
+        RunStringCase(thread_count, 100000, generator);
+    }
+}
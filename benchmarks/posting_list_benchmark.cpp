@@ -0,0 +1,99 @@
+// Сравнение сжатых списков вхождений с несжатыми (как в отображённом файле).
+// Сборка из каталога benchmarks (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server posting_list_benchmark.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/inverted_index.cpp
+//       ../search-server/index_segment.cpp ../search-server/term_arena.cpp
+//       -o posting_list_benchmark
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "inverted_index.h"
+
+using namespace std;
+
+struct Measurement {
+    double scan_ms = 0.0;
+    double contains_ms = 0.0;
+    double checksum = 0.0;
+};
+
+double MillisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+Measurement Measure(const PostingList& postings, const vector<int>& probes, int scans) {
+    Measurement result;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < scans; ++i) {
+        postings.ForEach([&result](int, double term_freq) {
+            result.checksum += term_freq;
+            });
+    }
+    result.scan_ms = MillisecondsSince(start) / scans;
+
+    start = chrono::steady_clock::now();
+    for (const int probe : probes) {
+        result.checksum += postings.Contains(probe);
+    }
+    result.contains_ms = MillisecondsSince(start);
+    return result;
+}
+
+void RunCase(const string& name, size_t size, int max_gap, int word_counts, mt19937& generator) {
+    vector<int> ids;
+    vector<double> freqs;
+    ids.reserve(size);
+    freqs.reserve(size);
+    int document_id = 0;
+    for (size_t i = 0; i < size; ++i) {
+        document_id += 1 + static_cast<int>(generator() % max_gap);
+        ids.push_back(document_id);
+        // частота слова - число вхождений, делённое на длину документа
+        freqs.push_back(1.0 / (1 + generator() % word_counts));
+    }
+    vector<int> probes(100000);
+    for (int& probe : probes) {
+        probe = static_cast<int>(generator() % (document_id + 1));
+    }
+
+    vector<double> block_max_freqs;
+    for (size_t i = 0; i < size; i += IndexSegment::POSTING_BLOCK_SIZE) {
+        block_max_freqs.push_back(*max_element(freqs.begin() + i, freqs.begin() + min(size, i + IndexSegment::POSTING_BLOCK_SIZE)));
+    }
+    const PostingList raw(ArrayView<int>(ids.data(), ids.size()), ArrayView<double>(freqs.data(), freqs.size()),
+        ArrayView<double>(block_max_freqs.data(), block_max_freqs.size()));
+    PostingList compressed;
+    for (size_t i = 0; i < size; ++i) {
+        compressed.Add(ids[i], freqs[i]);
+    }
+
+    const int scans = static_cast<int>(max<size_t>(1, 20000000 / size));
+    const Measurement raw_result = Measure(raw, probes, scans);
+    const Measurement compressed_result = Measure(compressed, probes, scans);
+    if (raw_result.checksum != compressed_result.checksum) {
+        cerr << "checksum mismatch in "s << name << endl;
+    }
+
+    const size_t raw_bytes = size * (sizeof(int) + sizeof(double));
+    cout << left << setw(24) << name << right
+        << setw(12) << raw_bytes << setw(12) << compressed.GetMemoryBytes()
+        << setw(12) << fixed << setprecision(3) << raw_result.scan_ms << setw(12) << compressed_result.scan_ms
+        << setw(12) << raw_result.contains_ms << setw(12) << compressed_result.contains_ms << endl;
+}
+
+int main() {
+    mt19937 generator(42);
+    cout << "decoder: "s << GetPostingDecoderName() << endl;
+    cout << left << setw(24) << "case"s << right
+        << setw(12) << "raw B"s << setw(12) << "packed B"s
+        << setw(12) << "raw scan"s << setw(12) << "packed scan"s
+        << setw(12) << "raw find"s << setw(12) << "packed find"s << endl;
+    RunCase("frequent 1M, gap<4"s, 1000000, 4, 30, generator);
+    RunCase("common 100K, gap<64"s, 100000, 64, 30, generator);
+    RunCase("rare 1K, gap<100K"s, 1000, 100000, 30, generator);
+    RunCase("long docs 1M, gap<4"s, 1000000, 4, 5000, generator);
+}
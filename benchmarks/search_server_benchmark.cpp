@@ -0,0 +1,388 @@
+// Замеры основных операций SearchServer на синтетическом корпусе
+// (см. synthetic_corpus.h): пропускная способность, задержка p50/p99,
+// число выделений памяти на операцию и пиковый RSS процесса после операции.
+// Параметры задаются как --имя=значение, например
+//   ./search_server_benchmark --documents=200000 --zipf=1.1 --json=v2.json --label=v2
+// Файл --json содержит параметры и результаты для сравнения версий.
+// Сборка из каталога benchmarks (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server search_server_benchmark.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o search_server_benchmark -ltbb -lpthread
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "synthetic_corpus.h"
+
+using namespace std;
+
+// Все выделения памяти процесса, в том числе в рабочих потоках.
+// Заменены все формы operator new и delete, чтобы любая пара new/delete
+// проходила через одну пару функций ниже.
+atomic<uint64_t> allocation_count = 0;
+
+namespace {
+
+void* Allocate(size_t size, size_t alignment) noexcept {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    size = max<size_t>(size, 1);
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return malloc(size);
+    }
+    // размер aligned_alloc должен быть кратен выравниванию
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void* AllocateOrThrow(size_t size, size_t alignment) {
+    if (void* pointer = Allocate(size, alignment)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void Deallocate(void* pointer) noexcept {
+    free(pointer);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    return AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size) {
+    return AllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, align_val_t alignment) {
+    return AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment) {
+    return AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return Allocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept {
+    Deallocate(pointer);
+}
+void operator delete[](void* pointer) noexcept {
+    Deallocate(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept {
+    Deallocate(pointer);
+}
+void operator delete[](void* pointer, size_t) noexcept {
+    Deallocate(pointer);
+}
+void operator delete(void* pointer, align_val_t) noexcept {
+    Deallocate(pointer);
+}
+void operator delete[](void* pointer, align_val_t) noexcept {
+    Deallocate(pointer);
+}
+void operator delete(void* pointer, size_t, align_val_t) noexcept {
+    Deallocate(pointer);
+}
+void operator delete[](void* pointer, size_t, align_val_t) noexcept {
+    Deallocate(pointer);
+}
+void operator delete(void* pointer, const nothrow_t&) noexcept {
+    Deallocate(pointer);
+}
+void operator delete[](void* pointer, const nothrow_t&) noexcept {
+    Deallocate(pointer);
+}
+void operator delete(void* pointer, align_val_t, const nothrow_t&) noexcept {
+    Deallocate(pointer);
+}
+void operator delete[](void* pointer, align_val_t, const nothrow_t&) noexcept {
+    Deallocate(pointer);
+}
+
+struct OperationResult {
+    string operation;
+    string policy;
+    size_t calls = 0;
+    // обработанные элементы: документы для пакетных операций, иначе вызовы
+    size_t items = 0;
+    double total_ms = 0.0;
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double allocations_per_call = 0.0;
+    long peak_rss_kb = 0;
+};
+
+long GetPeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// call(i) для i из [0, calls), каждый вызов замеряется отдельно
+template <typename Call>
+OperationResult Measure(const string& operation, const string& policy, size_t calls, size_t items, Call call) {
+    OperationResult result{ operation, policy, calls, items };
+    vector<double> latencies(calls);
+    const uint64_t allocations = allocation_count.load(memory_order_relaxed);
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        const auto call_start = chrono::steady_clock::now();
+        call(i);
+        latencies[i] = chrono::duration<double, micro>(chrono::steady_clock::now() - call_start).count();
+    }
+    result.total_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    result.allocations_per_call = calls > 0
+        ? static_cast<double>(allocation_count.load(memory_order_relaxed) - allocations) / calls
+        : 0.0;
+    if (calls > 0) {
+        sort(latencies.begin(), latencies.end());
+        result.p50_us = latencies[(calls - 1) / 2];
+        result.p99_us = latencies[(calls - 1) * 99 / 100];
+    }
+    result.peak_rss_kb = GetPeakRssKb();
+    return result;
+}
+
+void PrintHeader() {
+    cout << left << setw(24) << "operation"s << setw(6) << "policy"s << right
+        << setw(10) << "calls"s << setw(14) << "items/s"s
+        << setw(12) << "p50 us"s << setw(12) << "p99 us"s
+        << setw(12) << "allocs"s << setw(12) << "peak KB"s << endl;
+}
+
+void Print(const OperationResult& result) {
+    const double items_per_second = result.total_ms > 0.0 ? result.items * 1000.0 / result.total_ms : 0.0;
+    cout << left << setw(24) << result.operation << setw(6) << result.policy << right
+        << setw(10) << result.calls << setw(14) << fixed << setprecision(0) << items_per_second
+        << setw(12) << setprecision(1) << result.p50_us << setw(12) << result.p99_us
+        << setw(12) << result.allocations_per_call << setw(12) << result.peak_rss_kb << endl;
+}
+
+void WriteJson(const string& path, const string& label, const map<string, string>& options,
+    const vector<OperationResult>& results) {
+    ofstream output(path);
+    if (!output) {
+        throw runtime_error("Can't write "s + path);
+    }
+    output << "{\n  \"label\": \"" << label << "\",\n  \"options\": {";
+    bool is_first = true;
+    for (const auto& [name, value] : options) {
+        output << (is_first ? "\n" : ",\n") << "    \"" << name << "\": \"" << value << '"';
+        is_first = false;
+    }
+    output << "\n  },\n  \"results\": [";
+    is_first = true;
+    for (const OperationResult& result : results) {
+        const double items_per_second = result.total_ms > 0.0 ? result.items * 1000.0 / result.total_ms : 0.0;
+        output << (is_first ? "\n" : ",\n") << fixed << setprecision(3)
+            << "    {\"operation\": \"" << result.operation << "\", \"policy\": \"" << result.policy
+            << "\", \"calls\": " << result.calls << ", \"items\": " << result.items
+            << ", \"total_ms\": " << result.total_ms << ", \"items_per_second\": " << items_per_second
+            << ", \"p50_us\": " << result.p50_us << ", \"p99_us\": " << result.p99_us
+            << ", \"allocations_per_call\": " << result.allocations_per_call
+            << ", \"peak_rss_kb\": " << result.peak_rss_kb << '}';
+        is_first = false;
+    }
+    output << "\n  ]\n}\n";
+}
+
+// --имя=значение; имена, которых нет в options, - ошибка
+void ParseArguments(int argc, char* argv[], map<string, string>& options) {
+    for (int i = 1; i < argc; ++i) {
+        const string argument = argv[i];
+        const size_t separator = argument.find('=');
+        if (argument.rfind("--"s, 0) != 0 || separator == string::npos
+            || options.count(argument.substr(2, separator - 2)) == 0) {
+            throw invalid_argument("Unknown argument "s + argument);
+        }
+        options[argument.substr(2, separator - 2)] = argument.substr(separator + 1);
+    }
+}
+
+// различные id документов корпуса в случайном порядке
+vector<int> SampleDocumentIds(const SyntheticCorpus& corpus, size_t count, mt19937& generator) {
+    vector<int> ids;
+    ids.reserve(corpus.documents.size());
+    for (const DocumentToAdd& document : corpus.documents) {
+        ids.push_back(document.id);
+    }
+    shuffle(ids.begin(), ids.end(), generator);
+    ids.resize(min(count, ids.size()));
+    return ids;
+}
+
+int main(int argc, char* argv[]) {
+    map<string, string> arguments = {
+        {"seed"s, "42"s}, {"documents"s, "100000"s}, {"vocabulary"s, "50000"s}, {"zipf"s, "1.0"s},
+        {"min-length"s, "20"s}, {"max-length"s, "200"s}, {"actual-ratio"s, "0.85"s},
+        {"duplicates"s, "0.01"s}, {"stop-words"s, "20"s},
+        {"queries"s, "10000"s}, {"min-query-length"s, "1"s}, {"max-query-length"s, "5"s},
+        {"minus-probability"s, "0.1"s}, {"rare-queries"s, "0.2"s},
+        {"removals"s, "10000"s}, {"batch"s, "4096"s},
+        {"json"s, ""s}, {"label"s, ""s},
+    };
+    CorpusOptions options;
+    size_t removal_count = 0;
+    size_t batch_size = 0;
+    try {
+        ParseArguments(argc, argv, arguments);
+        options.seed = static_cast<uint32_t>(stoul(arguments.at("seed"s)));
+        options.document_count = stoul(arguments.at("documents"s));
+        options.vocabulary_size = stoul(arguments.at("vocabulary"s));
+        options.zipf_exponent = stod(arguments.at("zipf"s));
+        options.min_document_length = stoul(arguments.at("min-length"s));
+        options.max_document_length = stoul(arguments.at("max-length"s));
+        options.actual_ratio = stod(arguments.at("actual-ratio"s));
+        options.duplicate_ratio = stod(arguments.at("duplicates"s));
+        options.stop_word_count = stoul(arguments.at("stop-words"s));
+        options.query_count = stoul(arguments.at("queries"s));
+        options.min_query_length = stoul(arguments.at("min-query-length"s));
+        options.max_query_length = stoul(arguments.at("max-query-length"s));
+        options.minus_word_probability = stod(arguments.at("minus-probability"s));
+        options.rare_query_ratio = stod(arguments.at("rare-queries"s));
+        removal_count = stoul(arguments.at("removals"s));
+        batch_size = max<size_t>(1, stoul(arguments.at("batch"s)));
+    }
+    catch (const exception& error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+    if (options.vocabulary_size == 0 || options.min_document_length == 0
+        || options.min_document_length > options.max_document_length
+        || options.min_query_length > options.max_query_length) {
+        cerr << "Invalid corpus parameters"s << endl;
+        return 1;
+    }
+
+    const SyntheticCorpus corpus = GenerateCorpus(options);
+    const size_t document_count = corpus.documents.size();
+    const size_t query_count = corpus.queries.size();
+    mt19937 generator(options.seed);
+    const vector<int> removed_ids = SampleDocumentIds(corpus, removal_count, generator);
+    const vector<int> matched_ids = SampleDocumentIds(corpus, query_count, generator);
+    vector<vector<DocumentToAdd>> batches;
+    for (size_t i = 0; i < document_count; i += batch_size) {
+        batches.emplace_back(corpus.documents.begin() + i, corpus.documents.begin() + min(document_count, i + batch_size));
+    }
+
+    vector<OperationResult> results;
+    const auto run = [&results](OperationResult result) {
+        Print(result);
+        results.push_back(move(result));
+    };
+    PrintHeader();
+
+    SearchServer server(corpus.stop_words);
+    run(Measure("AddDocument"s, "seq"s, document_count, document_count, [&](size_t i) {
+        const DocumentToAdd& document = corpus.documents[i];
+        server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }));
+    {
+        SearchServer bulk_server(corpus.stop_words);
+        run(Measure("AddDocuments"s, "par"s, batches.size(), document_count, [&](size_t i) {
+            bulk_server.AddDocuments(batches[i]);
+            }));
+    }
+
+    // результаты складываются, чтобы поиск не выбросил оптимизатор
+    size_t checksum = 0;
+    run(Measure("FindTopDocuments"s, "seq"s, query_count, query_count, [&](size_t i) {
+        checksum += server.FindTopDocuments(execution::seq, corpus.queries[i]).size();
+        }));
+    run(Measure("FindTopDocuments"s, "par"s, query_count, query_count, [&](size_t i) {
+        checksum += server.FindTopDocuments(execution::par, corpus.queries[i]).size();
+        }));
+    run(Measure("MatchDocument"s, "seq"s, query_count, query_count, [&](size_t i) {
+        checksum += get<0>(server.MatchDocument(execution::seq, corpus.queries[i], matched_ids[i % matched_ids.size()])).size();
+        }));
+    run(Measure("MatchDocument"s, "par"s, query_count, query_count, [&](size_t i) {
+        checksum += get<0>(server.MatchDocument(execution::par, corpus.queries[i], matched_ids[i % matched_ids.size()])).size();
+        }));
+
+    // удаления идут в копиях, которые разделяют данные с server до изменения
+    {
+        SearchServer copy(server);
+        run(Measure("RemoveDocument"s, "seq"s, removed_ids.size(), removed_ids.size(), [&](size_t i) {
+            copy.RemoveDocument(execution::seq, removed_ids[i]);
+            }));
+    }
+    {
+        SearchServer copy(server);
+        run(Measure("RemoveDocument"s, "par"s, removed_ids.size(), removed_ids.size(), [&](size_t i) {
+            copy.RemoveDocument(execution::par, removed_ids[i]);
+            }));
+    }
+    {
+        SearchServer copy(server);
+        const size_t batch_count = (removed_ids.size() + batch_size - 1) / batch_size;
+        run(Measure("RemoveDocuments"s, "batch"s, batch_count, removed_ids.size(), [&](size_t i) {
+            copy.RemoveDocuments(vector<int>(removed_ids.begin() + i * batch_size,
+                removed_ids.begin() + min(removed_ids.size(), (i + 1) * batch_size)));
+            }));
+        run(Measure("PurgeRemovedDocuments"s, "par"s, 1, removed_ids.size(), [&](size_t) {
+            copy.PurgeRemovedDocuments();
+            }));
+    }
+    {
+        SearchServer copy(server);
+        // документы уходят в IRRELEVANT, вхождения переносятся между частями списков
+        run(Measure("SetDocumentStatus"s, "seq"s, removed_ids.size(), removed_ids.size(), [&](size_t i) {
+            copy.SetDocumentStatus(removed_ids[i], DocumentStatus::IRRELEVANT);
+            }));
+    }
+    {
+        SearchServer copy(server);
+        // RemoveDuplicates печатает каждый дубликат, вывод отключается
+        streambuf* const output = cout.rdbuf(nullptr);
+        const OperationResult result = Measure("RemoveDuplicates"s, "par"s, 1, document_count, [&](size_t) {
+            RemoveDuplicates(copy);
+            });
+        cout.rdbuf(output);
+        cout.clear();
+        run(result);
+    }
+    cerr << "checksum: "s << checksum << endl;
+
+    const string& json_path = arguments.at("json"s);
+    if (!json_path.empty()) {
+        map<string, string> json_options = arguments;
+        json_options.erase("json"s);
+        json_options.erase("label"s);
+        try {
+            WriteJson(json_path, arguments.at("label"s), json_options, results);
+        }
+        catch (const exception& error) {
+            cerr << error.what() << endl;
+            return 1;
+        }
+    }
+}
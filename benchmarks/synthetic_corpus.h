@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "search_server.h"
+
+// Параметры синтетического корпуса. Слово ранга r (с нуля) встречается
+// с вероятностью, пропорциональной 1 / (r + 1)^zipf_exponent, как слова
+// естественного языка. Одинаковые параметры дают одинаковый корпус.
+struct CorpusOptions {
+    uint32_t seed = 42;
+    size_t document_count = 100000;
+    size_t vocabulary_size = 50000;
+    double zipf_exponent = 1.0;
+    size_t min_document_length = 20;
+    size_t max_document_length = 200;
+    // доля документов со статусом ACTUAL, остальные статусы поровну
+    double actual_ratio = 0.85;
+    // доля документов, повторяющих слова более раннего документа
+    // в другом порядке, для RemoveDuplicates
+    double duplicate_ratio = 0.01;
+    // самые частые слова становятся стоп-словами
+    size_t stop_word_count = 20;
+
+    size_t query_count = 10000;
+    size_t min_query_length = 1;
+    size_t max_query_length = 5;
+    // вероятность, что слово запроса - минус-слово
+    double minus_word_probability = 0.1;
+    // доля запросов из слов, выбранных равномерно по словарю, то есть
+    // в основном редких; слова остальных запросов выбираются по Ципфу
+    double rare_query_ratio = 0.2;
+};
+
+struct SyntheticCorpus {
+    std::vector<std::string> stop_words;
+    std::vector<DocumentToAdd> documents;
+    std::vector<std::string> queries;
+};
+
+// ранги [0, size) по закону Ципфа
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t size, double exponent)
+        : cdf_(size) {
+        double sum = 0.0;
+        for (size_t rank = 0; rank < size; ++rank) {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+            cdf_[rank] = sum;
+        }
+        for (double& value : cdf_) {
+            value /= sum;
+        }
+    }
+
+    template <typename Generator>
+    size_t operator()(Generator& generator) const {
+        const double value = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+        const size_t rank = std::upper_bound(cdf_.begin(), cdf_.end(), value) - cdf_.begin();
+        return std::min(rank, cdf_.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+// слово ранга rank: различные строчные слова, короткие у частых рангов
+inline std::string MakeCorpusWord(size_t rank) {
+    std::string word;
+    do {
+        word.push_back(static_cast<char>('a' + rank % 26));
+        rank /= 26;
+    } while (rank > 0);
+    return word;
+}
+
+inline SyntheticCorpus GenerateCorpus(const CorpusOptions& options) {
+    std::mt19937 generator(options.seed);
+    const ZipfDistribution zipf(options.vocabulary_size, options.zipf_exponent);
+    std::vector<std::string> words(options.vocabulary_size);
+    for (size_t rank = 0; rank < words.size(); ++rank) {
+        words[rank] = MakeCorpusWord(rank);
+    }
+
+    SyntheticCorpus corpus;
+    corpus.stop_words.assign(words.begin(), words.begin() + std::min(options.stop_word_count, words.size()));
+
+    std::uniform_int_distribution<size_t> document_length(options.min_document_length, options.max_document_length);
+    std::uniform_real_distribution<double> probability(0.0, 1.0);
+    std::uniform_int_distribution<int> rating(-10, 10);
+    std::uniform_int_distribution<int> rating_count(1, 5);
+    static constexpr DocumentStatus OTHER_STATUSES[] = {
+        DocumentStatus::IRRELEVANT, DocumentStatus::BANNED, DocumentStatus::REMOVED };
+
+    corpus.documents.reserve(options.document_count);
+    std::vector<std::string> document_words;
+    for (size_t i = 0; i < options.document_count; ++i) {
+        DocumentToAdd& document = corpus.documents.emplace_back();
+        document.id = static_cast<int>(i);
+        document.status = probability(generator) < options.actual_ratio
+            ? DocumentStatus::ACTUAL
+            : OTHER_STATUSES[generator() % 3];
+        document.ratings.resize(rating_count(generator));
+        for (int& value : document.ratings) {
+            value = rating(generator);
+        }
+
+        if (i > 0 && probability(generator) < options.duplicate_ratio) {
+            // дубликат: те же слова более раннего документа в другом порядке
+            const std::string& original = corpus.documents[generator() % i].text;
+            document_words.clear();
+            for (size_t begin = 0; begin < original.size();) {
+                const size_t end = std::min(original.find(' ', begin), original.size());
+                document_words.push_back(original.substr(begin, end - begin));
+                begin = end + 1;
+            }
+            std::shuffle(document_words.begin(), document_words.end(), generator);
+        }
+        else {
+            document_words.resize(document_length(generator));
+            for (std::string& word : document_words) {
+                word = words[zipf(generator)];
+            }
+        }
+        for (const std::string& word : document_words) {
+            if (!document.text.empty()) {
+                document.text.push_back(' ');
+            }
+            document.text += word;
+        }
+    }
+
+    std::uniform_int_distribution<size_t> query_length(options.min_query_length, options.max_query_length);
+    std::uniform_int_distribution<size_t> uniform_rank(0, options.vocabulary_size - 1);
+    corpus.queries.reserve(options.query_count);
+    for (size_t i = 0; i < options.query_count; ++i) {
+        const bool is_rare = probability(generator) < options.rare_query_ratio;
+        std::string& query = corpus.queries.emplace_back();
+        const size_t length = query_length(generator);
+        for (size_t j = 0; j < length; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            if (probability(generator) < options.minus_word_probability) {
+                query.push_back('-');
+            }
+            query += words[is_rare ? uniform_rank(generator) : zipf(generator)];
+        }
+    }
+    return corpus;
+}
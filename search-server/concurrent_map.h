@@ -1,60 +1,213 @@
 #pragma once
-#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <execution>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
 #include <vector>
 
-using namespace std::string_literals;
-
-template <typename Key, typename Value>
+// Словарь для параллельного накопления значений по ключам любого типа
+// с хешем. Ключи распределяются по полосам по хешу; у каждой полосы
+// своя короткая блокировка и своя плоская таблица: пары ключ-значение
+// лежат подряд в массиве, а открытая адресация хранит только номера пар.
+// Вставка не выделяет память под каждый ключ, потоки, работающие
+// с разными полосами, не мешают друг другу, и каждая полоса занимает
+// свои кеш-линии. Полос стоит брать в несколько раз больше, чем потоков.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
 class ConcurrentMap {
 private:
-    struct Bucket {
-        std::mutex mutex;
-        std::map<Key, Value> map;
+    // Критические участки короче переключения потока, поэтому поток
+    // ждёт блокировку активно и уступает процессор, только если ждёт долго.
+    class SpinLock {
+    public:
+        void lock() {
+            int spins = 0;
+            while (locked_.exchange(true, std::memory_order_acquire)) {
+                while (locked_.load(std::memory_order_relaxed)) {
+                    if (++spins == MAX_SPINS) {
+                        std::this_thread::yield();
+                        spins = 0;
+                    }
+                }
+            }
+        }
+
+        void unlock() {
+            locked_.store(false, std::memory_order_release);
+        }
+
+    private:
+        static constexpr int MAX_SPINS = 64;
+
+        std::atomic<bool> locked_ = false;
     };
 
-public:
-    static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys"s);
+    struct alignas(64) Bucket {
+        SpinLock lock;
+        std::vector<std::pair<Key, Value>> entries;
+        std::vector<uint64_t> hashes;
+        // номера пар в entries или EMPTY_SLOT; размер - степень двойки
+        std::vector<uint32_t> slots;
+    };
 
+public:
     struct Access {
-        std::lock_guard <std::mutex> guard;
+        std::lock_guard<SpinLock> guard;
         Value& ref_to_value;
 
-        Access(const Key& key, Bucket& bucket)
-            : guard(bucket.mutex),
-            ref_to_value(bucket.map[key])
+        Access(const Key& key, uint64_t hash, Bucket& bucket)
+            : guard(bucket.lock),
+            ref_to_value(FindOrInsert(bucket, key, hash))
         {
         }
     };
 
     explicit ConcurrentMap(size_t bucket_count)
-        : buckets_(bucket_count)
+        : buckets_(std::max<size_t>(bucket_count, 1))
     {
     }
 
+    // значение по ключу; полоса ключа заблокирована, пока жив Access
     Access operator[](const Key& key) {
-        auto& bucket = buckets_[key % buckets_.size()];
-        return { key, bucket };
+        const uint64_t hash = GetHash(key);
+        return { key, hash, GetBucket(hash) };
+    }
+
+    bool Erase(const Key& key) {
+        const uint64_t hash = GetHash(key);
+        Bucket& bucket = GetBucket(hash);
+        std::lock_guard guard(bucket.lock);
+        size_t slot = FindSlot(bucket, key, hash);
+        if (slot == NOT_FOUND) {
+            return false;
+        }
+        const uint32_t index = bucket.slots[slot];
+
+        // последняя пара переезжает на место удалённой
+        const uint32_t last = static_cast<uint32_t>(bucket.entries.size() - 1);
+        if (index != last) {
+            bucket.slots[FindSlot(bucket, bucket.entries[last].first, bucket.hashes[last])] = index;
+            bucket.entries[index] = std::move(bucket.entries[last]);
+            bucket.hashes[index] = bucket.hashes[last];
+        }
+        bucket.entries.pop_back();
+        bucket.hashes.pop_back();
+
+        // пробы, проходившие через освобождённую ячейку, сдвигаются назад
+        const size_t mask = bucket.slots.size() - 1;
+        for (size_t next = (slot + 1) & mask; bucket.slots[next] != EMPTY_SLOT; next = (next + 1) & mask) {
+            const size_t home = bucket.hashes[bucket.slots[next]] & mask;
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                bucket.slots[slot] = bucket.slots[next];
+                slot = next;
+            }
+        }
+        bucket.slots[slot] = EMPTY_SLOT;
+        return true;
+    }
+
+    // все пары одним массивом без упорядочивания; полосы копируются параллельно
+    std::vector<std::pair<Key, Value>> BuildVector() {
+        std::vector<size_t> offsets(buckets_.size() + 1, 0);
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            std::lock_guard guard(buckets_[i].lock);
+            offsets[i + 1] = offsets[i] + buckets_[i].entries.size();
+        }
+        std::vector<std::pair<Key, Value>> result(offsets.back());
+        ForEachBucket(std::execution::par, [&result, &offsets](size_t index, const std::vector<std::pair<Key, Value>>& entries) {
+            std::copy(entries.begin(), entries.end(), result.begin() + offsets[index]);
+            });
+        return result;
     }
 
     std::map<Key, Value> BuildOrdinaryMap() {
         std::map<Key, Value> result;
-        for (auto& [mutex, map] : buckets_) {
-            std::lock_guard guard(mutex);
-            result.insert(map.begin(), map.end());
+        for (Bucket& bucket : buckets_) {
+            std::lock_guard guard(bucket.lock);
+            result.insert(bucket.entries.begin(), bucket.entries.end());
         }
         return result;
     }
-    
-    auto dell(const Key& key) -> bool {
-        const auto bucket_index = std::hash<Key>{}(key) % buckets_.size();
-        std::scoped_lock lock(buckets_[bucket_index].mutex);
-        auto& bucket = buckets_[bucket_index];
 
-        return bucket.map.erase(key) != 0;
+    // function(bucket_index, bucket_entries) для каждой полосы
+    template <typename ExecutionPolicy, typename Function>
+    void ForEachBucket(ExecutionPolicy&& policy, Function function) {
+        std::vector<size_t> indexes(buckets_.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+        std::for_each(policy, indexes.begin(), indexes.end(), [this, &function](size_t index) {
+            std::lock_guard guard(buckets_[index].lock);
+            function(index, std::as_const(buckets_[index].entries));
+            });
     }
 
 private:
-   
+    static constexpr uint32_t EMPTY_SLOT = static_cast<uint32_t>(-1);
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    static constexpr size_t MIN_SLOT_COUNT = 8;
+
+    // перемешивает биты хеша: std::hash для чисел часто тождественный,
+    // а полоса и ячейка берутся из разных частей хеша
+    static uint64_t GetHash(const Key& key) {
+        uint64_t hash = static_cast<uint64_t>(Hash{}(key)) + 0x9e3779b97f4a7c15ull;
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+
+    Bucket& GetBucket(uint64_t hash) {
+        return buckets_[(hash >> 32) % buckets_.size()];
+    }
+
+    // ячейка пары с ключом или NOT_FOUND
+    static size_t FindSlot(const Bucket& bucket, const Key& key, uint64_t hash) {
+        if (bucket.slots.empty()) {
+            return NOT_FOUND;
+        }
+        const size_t mask = bucket.slots.size() - 1;
+        for (size_t slot = hash & mask; bucket.slots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+            const uint32_t index = bucket.slots[slot];
+            if (bucket.hashes[index] == hash && KeyEqual{}(bucket.entries[index].first, key)) {
+                return slot;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    static Value& FindOrInsert(Bucket& bucket, const Key& key, uint64_t hash) {
+        if (const size_t slot = FindSlot(bucket, key, hash); slot != NOT_FOUND) {
+            return bucket.entries[bucket.slots[slot]].second;
+        }
+        // таблица заполнена не больше чем наполовину
+        if ((bucket.entries.size() + 1) * 2 > bucket.slots.size()) {
+            Rehash(bucket, std::max(MIN_SLOT_COUNT, bucket.slots.size() * 2));
+        }
+        const size_t mask = bucket.slots.size() - 1;
+        size_t slot = hash & mask;
+        while (bucket.slots[slot] != EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
+        }
+        bucket.slots[slot] = static_cast<uint32_t>(bucket.entries.size());
+        bucket.entries.emplace_back(key, Value{});
+        bucket.hashes.push_back(hash);
+        return bucket.entries.back().second;
+    }
+
+    static void Rehash(Bucket& bucket, size_t slot_count) {
+        bucket.slots.assign(slot_count, EMPTY_SLOT);
+        const size_t mask = slot_count - 1;
+        for (uint32_t index = 0; index < bucket.entries.size(); ++index) {
+            size_t slot = bucket.hashes[index] & mask;
+            while (bucket.slots[slot] != EMPTY_SLOT) {
+                slot = (slot + 1) & mask;
+            }
+            bucket.slots[slot] = index;
+        }
+    }
+
     std::vector<Bucket> buckets_;
 };
@@ -0,0 +1,386 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Указатель с копированием при записи. Копии разделяют один объект,
+// пока какая-нибудь из них не запросит его на изменение.
+// Изменять объект может только один поток-владелец копии.
+template <typename T>
+class CowPtr {
+public:
+    CowPtr()
+        : ptr_(std::make_shared<T>()) {
+    }
+
+    explicit CowPtr(T value)
+        : ptr_(std::make_shared<T>(std::move(value))) {
+    }
+
+    const T& operator*() const {
+        return *ptr_;
+    }
+
+    const T* operator->() const {
+        return ptr_.get();
+    }
+
+    T& Mutable() {
+        if (ptr_.use_count() > 1) {
+            ptr_ = std::make_shared<T>(*ptr_);
+        }
+        return *ptr_;
+    }
+
+private:
+    std::shared_ptr<T> ptr_;
+};
+
+// Вектор из блоков по CHUNK_SIZE элементов с копированием блоков при записи.
+// Указатели на блоки собраны в таблицы по TABLE_SIZE, которые тоже
+// копируются при записи: копия вектора стоит size / (CHUNK_SIZE * TABLE_SIZE)
+// указателей, запись копирует только блок и таблицу, которые ещё
+// разделяются с другими копиями.
+// Начало вектора может читаться из внешней памяти (например, отображённого
+// файла): такие блоки копируются в память при первой записи.
+template <typename T, size_t CHUNK_SIZE = 1024>
+class CowVector {
+public:
+    static constexpr size_t TABLE_SIZE = 64;
+
+    CowVector() = default;
+
+    // первые size элементов читаются из base, а при base == nullptr равны T{}
+    CowVector(size_t size, std::shared_ptr<const T> base)
+        : base_(std::move(base))
+        , base_size_(size)
+        , size_(size) {
+        const size_t chunk_count = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        for (size_t first = 0; first < chunk_count; first += TABLE_SIZE) {
+            tables_.push_back(std::make_shared<Table>(std::min(TABLE_SIZE, chunk_count - first)));
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const T& operator[](size_t index) const {
+        const auto& chunk = GetChunk(index / CHUNK_SIZE);
+        if (chunk) {
+            return (*chunk)[index % CHUNK_SIZE];
+        }
+        static const T default_value{};
+        return base_ ? base_.get()[index] : default_value;
+    }
+
+    const T& back() const {
+        return (*this)[size_ - 1];
+    }
+
+    T& Mutable(size_t index) {
+        return MutableChunk(index / CHUNK_SIZE)[index % CHUNK_SIZE];
+    }
+
+    // func(index, data, count) для непрерывных участков [first, last):
+    // data[0, count) - элементы с номерами [index, index + count)
+    template <typename Func>
+    void ForEachSpan(size_t first, size_t last, Func func) const {
+        static const std::vector<T> default_chunk(CHUNK_SIZE);
+        while (first < last) {
+            const size_t chunk_index = first / CHUNK_SIZE;
+            const size_t offset = first % CHUNK_SIZE;
+            const size_t count = std::min(last - first, CHUNK_SIZE - offset);
+            const auto& chunk = GetChunk(chunk_index);
+            const T* data = chunk ? chunk->data() + offset
+                : base_ ? base_.get() + first
+                : default_chunk.data() + offset;
+            func(first, data, count);
+            first += count;
+        }
+    }
+
+    void push_back(T value) {
+        if (size_ % CHUNK_SIZE == 0) {
+            const size_t chunk_index = size_ / CHUNK_SIZE;
+            if (chunk_index % TABLE_SIZE == 0) {
+                tables_.push_back(std::make_shared<Table>());
+                tables_.back()->reserve(TABLE_SIZE);
+            }
+            auto chunk = std::make_shared<std::vector<T>>();
+            chunk->reserve(CHUNK_SIZE);
+            MutableTable(chunk_index / TABLE_SIZE).push_back(std::move(chunk));
+        }
+        MutableChunk(size_ / CHUNK_SIZE).push_back(std::move(value));
+        ++size_;
+    }
+
+    void pop_back() {
+        --size_;
+        const size_t chunk_index = size_ / CHUNK_SIZE;
+        if (size_ % CHUNK_SIZE != 0) {
+            MutableChunk(chunk_index).pop_back();
+            return;
+        }
+        // опустевший блок освобождается, а не копируется
+        MutableTable(chunk_index / TABLE_SIZE).pop_back();
+        if (chunk_index % TABLE_SIZE == 0) {
+            tables_.pop_back();
+        }
+        base_size_ = std::min(base_size_, size_);
+    }
+
+private:
+    using Table = std::vector<std::shared_ptr<std::vector<T>>>;
+
+    const std::shared_ptr<std::vector<T>>& GetChunk(size_t chunk_index) const {
+        return (*tables_[chunk_index / TABLE_SIZE])[chunk_index % TABLE_SIZE];
+    }
+
+    Table& MutableTable(size_t table_index) {
+        auto& table = tables_[table_index];
+        if (table.use_count() > 1) {
+            auto copy = std::make_shared<Table>();
+            copy->reserve(TABLE_SIZE);
+            copy->assign(table->begin(), table->end());
+            table = std::move(copy);
+        }
+        return *table;
+    }
+
+    std::vector<T>& MutableChunk(size_t chunk_index) {
+        auto& chunk = MutableTable(chunk_index / TABLE_SIZE)[chunk_index % TABLE_SIZE];
+        if (!chunk) {
+            const size_t first = chunk_index * CHUNK_SIZE;
+            const size_t last = std::min(base_size_, first + CHUNK_SIZE);
+            chunk = std::make_shared<std::vector<T>>();
+            chunk->reserve(CHUNK_SIZE);
+            if (base_) {
+                chunk->assign(base_.get() + first, base_.get() + last);
+            }
+            else {
+                chunk->resize(last - first);
+            }
+        }
+        else if (chunk.use_count() > 1) {
+            auto copy = std::make_shared<std::vector<T>>();
+            copy->reserve(CHUNK_SIZE);
+            copy->assign(chunk->begin(), chunk->end());
+            chunk = std::move(copy);
+        }
+        return *chunk;
+    }
+
+    // пустой блок ещё не скопирован из base_
+    std::vector<std::shared_ptr<Table>> tables_;
+    std::shared_ptr<const T> base_;
+    size_t base_size_ = 0;
+    size_t size_ = 0;
+};
+
+// Хеш-таблица из сегментов с копированием сегментов при записи.
+// Число сегментов удваивается вместе с числом записей, а сами сегменты
+// хранятся в CowVector: копия таблицы стоит долю указателя на сегмент,
+// запись копирует один сегмент и его таблицу указателей.
+template <typename Key, typename Value>
+class CowHashMap {
+public:
+    using Shard = std::unordered_map<Key, Value>;
+
+    CowHashMap() {
+        for (size_t i = 0; i < MIN_SHARD_COUNT; ++i) {
+            shards_.push_back({});
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    const Value* Find(const Key& key) const {
+        const Shard& shard = *shards_[GetShardIndex(key)];
+        const auto it = shard.find(key);
+        return it == shard.end() ? nullptr : &it->second;
+    }
+
+    Value* FindMutable(const Key& key) {
+        const auto entry = FindEntryMutable(key);
+        return entry == nullptr ? nullptr : &entry->second;
+    }
+
+    // пара (ключ, значение), ключ нужен, если он ссылается на внешние данные
+    typename Shard::value_type* FindEntryMutable(const Key& key) {
+        const size_t shard_index = GetShardIndex(key);
+        if (shards_[shard_index]->count(key) == 0) {
+            return nullptr;
+        }
+        return &*shards_.Mutable(shard_index).Mutable().find(key);
+    }
+
+    std::pair<typename Shard::iterator, bool> Emplace(Key key, Value value) {
+        if (size_ >= shards_.size() * SHARD_LOAD) {
+            Grow();
+        }
+        auto result = shards_.Mutable(GetShardIndex(key)).Mutable().emplace(std::move(key), std::move(value));
+        size_ += result.second;
+        return result;
+    }
+
+    bool Erase(const Key& key) {
+        const size_t shard_index = GetShardIndex(key);
+        if (shards_[shard_index]->count(key) == 0) {
+            return false;
+        }
+        shards_.Mutable(shard_index).Mutable().erase(key);
+        --size_;
+        return true;
+    }
+
+    // func(key, value) для каждой записи, порядок не определён
+    template <typename Func>
+    void ForEach(Func func) const {
+        shards_.ForEachSpan(0, shards_.size(), [&](size_t, const CowPtr<Shard>* shards, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                for (const auto& [key, value] : *shards[i]) {
+                    func(key, value);
+                }
+            }
+            });
+    }
+
+private:
+    static constexpr size_t MIN_SHARD_COUNT = 16;
+    // среднее число записей в сегменте, после которого сегменты удваиваются
+    static constexpr size_t SHARD_LOAD = 64;
+
+    size_t GetShardIndex(const Key& key) const {
+        return std::hash<Key>{}(key) & (shards_.size() - 1);
+    }
+
+    // сегмент i делится на i и i + old_count по следующему биту хеша
+    void Grow() {
+        const size_t old_count = shards_.size();
+        for (size_t i = 0; i < old_count; ++i) {
+            shards_.push_back({});
+        }
+        for (size_t i = 0; i < old_count; ++i) {
+            if (shards_[i]->empty()) {
+                continue;
+            }
+            Shard& low = shards_.Mutable(i).Mutable();
+            Shard& high = shards_.Mutable(i + old_count).Mutable();
+            for (auto it = low.begin(); it != low.end();) {
+                if (std::hash<Key>{}(it->first) & old_count) {
+                    high.insert(low.extract(it++));
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    CowVector<CowPtr<Shard>, 64> shards_;
+    size_t size_ = 0;
+};
+
+// Производный объект, который строится при первом обращении.
+// Копии разделяют уже построенный объект; владелец копии правит его
+// на месте, пока объект не разделяется, и сбрасывает в противном случае.
+template <typename T>
+class LazyValue {
+public:
+    LazyValue() = default;
+
+    LazyValue(const LazyValue& other)
+        : value_(other.Share()) {
+    }
+
+    LazyValue& operator=(const LazyValue& other) {
+        if (this != &other) {
+            auto value = other.Share();
+            std::lock_guard guard(mutex_);
+            value_ = std::move(value);
+        }
+        return *this;
+    }
+
+    // builder() -> T вызывается, если объект ещё не построен
+    template <typename Builder>
+    T& Get(Builder builder) const {
+        std::lock_guard guard(mutex_);
+        if (!value_) {
+            value_ = std::make_shared<T>(builder());
+        }
+        return *value_;
+    }
+
+    // modifier(T&) применяется, только если объект построен и не разделяется
+    template <typename Modifier>
+    void Update(Modifier modifier) {
+        std::lock_guard guard(mutex_);
+        if (value_ && value_.use_count() == 1) {
+            modifier(*value_);
+        }
+        else {
+            value_.reset();
+        }
+    }
+
+private:
+    std::shared_ptr<T> Share() const {
+        std::lock_guard guard(mutex_);
+        return value_;
+    }
+
+    mutable std::mutex mutex_;
+    mutable std::shared_ptr<T> value_;
+};
+
+// Значения, которые строятся по требованию и хранятся до удаления.
+// Копия начинает с пустого кеша: построенные значения не разделяются.
+template <typename Key, typename Value>
+class LazyMap {
+public:
+    LazyMap() = default;
+
+    LazyMap(const LazyMap&) {
+    }
+
+    LazyMap& operator=(const LazyMap&) {
+        Clear();
+        return *this;
+    }
+
+    // builder() -> Value вызывается, если значения для key ещё нет;
+    // ссылка действительна до Erase(key) или Clear()
+    template <typename Builder>
+    const Value& Get(const Key& key, Builder builder) const {
+        std::lock_guard guard(mutex_);
+        auto it = values_.find(key);
+        if (it == values_.end()) {
+            it = values_.emplace(key, builder()).first;
+        }
+        return it->second;
+    }
+
+    void Erase(const Key& key) {
+        std::lock_guard guard(mutex_);
+        values_.erase(key);
+    }
+
+    void Clear() {
+        std::lock_guard guard(mutex_);
+        values_.clear();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<Key, Value> values_;
+};
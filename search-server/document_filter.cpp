@@ -0,0 +1,49 @@
+#include "document_filter.h"
+
+#if defined(__SSE2__) && !defined(DOCUMENT_FILTER_NO_SIMD)
+#include <emmintrin.h>
+#define DOCUMENT_FILTER_SSE2
+#endif
+
+void FillStatusMask(const uint8_t* statuses, size_t count, DocumentStatus status, uint8_t* mask) {
+    const uint8_t value = static_cast<uint8_t>(status);
+    size_t i = 0;
+#ifdef DOCUMENT_FILTER_SSE2
+    const __m128i values = _mm_set1_epi8(static_cast<char>(value));
+    for (; i + 16 <= count; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(statuses + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), _mm_cmpeq_epi8(chunk, values));
+    }
+#endif
+    for (; i < count; ++i) {
+        mask[i] = statuses[i] == value ? 0xFF : 0;
+    }
+}
+
+void FillRatingMask(const uint8_t* statuses, const int* ratings, size_t count,
+    int min_rating, int max_rating, uint8_t* mask) {
+    size_t i = 0;
+#ifdef DOCUMENT_FILTER_SSE2
+    // Четыре сравнения по 4 рейтинга сжимаются с насыщением в 16 байт
+    // 0xFF или 0, затем из них вычитаются номера без документа.
+    const __m128i min_values = _mm_set1_epi32(min_rating);
+    const __m128i max_values = _mm_set1_epi32(max_rating);
+    const __m128i no_status = _mm_set1_epi8(static_cast<char>(NO_DOCUMENT_STATUS));
+    const auto out_of_range = [&](const int* data) {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        return _mm_or_si128(_mm_cmplt_epi32(values, min_values), _mm_cmpgt_epi32(values, max_values));
+    };
+    for (; i + 16 <= count; i += 16) {
+        const __m128i rejected = _mm_or_si128(
+            _mm_packs_epi16(
+                _mm_packs_epi32(out_of_range(ratings + i), out_of_range(ratings + i + 4)),
+                _mm_packs_epi32(out_of_range(ratings + i + 8), out_of_range(ratings + i + 12))),
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(statuses + i)), no_status));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), _mm_andnot_si128(rejected, _mm_set1_epi8(-1)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const bool admitted = statuses[i] != NO_DOCUMENT_STATUS && min_rating <= ratings[i] && ratings[i] <= max_rating;
+        mask[i] = admitted ? 0xFF : 0;
+    }
+}
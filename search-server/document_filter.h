@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "document.h"
+
+// Описания частых фильтров документов. Каждое описание - обычный предикат
+// (document_id, status, rating), но сервер узнаёт его тип при компиляции
+// и проверяет документы по плотным столбцам статусов и рейтингов, не вызывая
+// предикат на каждое вхождение. Для длинных списков маска фильтра строится
+// сразу по всему диапазону документов пачками по 16. Любой другой
+// предикат проверяется как раньше.
+
+// документ со статусом status
+struct StatusFilter {
+    DocumentStatus status = DocumentStatus::ACTUAL;
+
+    bool operator()(int, DocumentStatus document_status, int) const {
+        return document_status == status;
+    }
+};
+
+// документ с рейтингом из [min_rating, max_rating] при любом статусе
+struct RatingFilter {
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+
+    bool operator()(int, DocumentStatus, int rating) const {
+        return min_rating <= rating && rating <= max_rating;
+    }
+};
+
+// документ из заданного набора id; копии фильтра разделяют набор
+class DocumentIdFilter {
+public:
+    template <typename DocumentIds>
+    explicit DocumentIdFilter(const DocumentIds& document_ids);
+
+    bool operator()(int document_id, DocumentStatus, int) const {
+        return Contains(document_id);
+    }
+
+    bool Contains(int document_id) const {
+        return std::binary_search(document_ids_->begin(), document_ids_->end(), document_id);
+    }
+
+    // по возрастанию, без повторов
+    const std::vector<int>& GetDocumentIds() const {
+        return *document_ids_;
+    }
+
+private:
+    std::shared_ptr<const std::vector<int>> document_ids_;
+};
+
+template <typename DocumentPredicate>
+constexpr bool IS_DOCUMENT_FILTER = std::is_same_v<std::remove_cv_t<DocumentPredicate>, StatusFilter>
+    || std::is_same_v<std::remove_cv_t<DocumentPredicate>, RatingFilter>
+    || std::is_same_v<std::remove_cv_t<DocumentPredicate>, DocumentIdFilter>;
+
+// Статус, которым предикат ограничивает документы, если он известен при
+// компиляции: поиск тогда обходит только вхождения документов этого статуса.
+template <typename DocumentPredicate>
+std::optional<DocumentStatus> GetFilteredStatus(const DocumentPredicate& document_predicate) {
+    if constexpr (std::is_same_v<std::remove_cv_t<DocumentPredicate>, StatusFilter>) {
+        return document_predicate.status;
+    }
+    else {
+        return std::nullopt;
+    }
+}
+
+// статус в столбце статусов для номера без документа
+constexpr uint8_t NO_DOCUMENT_STATUS = 0xFF;
+
+// Маски фильтров для count подряд идущих документов: mask[i] = 0xFF, если
+// документ i проходит фильтр, иначе 0. Номера без документа не проходят.
+void FillStatusMask(const uint8_t* statuses, size_t count, DocumentStatus status, uint8_t* mask);
+void FillRatingMask(const uint8_t* statuses, const int* ratings, size_t count,
+    int min_rating, int max_rating, uint8_t* mask);
+
+template <typename DocumentIds>
+DocumentIdFilter::DocumentIdFilter(const DocumentIds& document_ids) {
+    std::vector<int> ids(std::begin(document_ids), std::end(document_ids));
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    document_ids_ = std::make_shared<const std::vector<int>>(std::move(ids));
+}
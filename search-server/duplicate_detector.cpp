@@ -0,0 +1,159 @@
+#include "duplicate_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace {
+
+const size_t SIGNATURE_SIZE = 128;
+// полосы подбираются с запасом, чтобы пары на пороге редко терялись
+const double BAND_THRESHOLD_MARGIN = 0.85;
+
+uint64_t Mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+uint64_t HashRange(const uint64_t* first, const uint64_t* last) {
+    uint64_t hash = Mix(static_cast<uint64_t>(last - first));
+    for (; first != last; ++first) {
+        hash = Mix(hash ^ *first);
+    }
+    return hash;
+}
+
+void EraseFromBucket(std::unordered_map<uint64_t, std::vector<int>>& buckets, uint64_t key, int document_id) {
+    const auto it = buckets.find(key);
+    if (it == buckets.end()) {
+        return;
+    }
+    auto& ids = it->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), document_id), ids.end());
+    if (ids.empty()) {
+        buckets.erase(it);
+    }
+}
+
+} // namespace
+
+DuplicateDetector::DuplicateDetector(double similarity)
+    : similarity_(similarity) {
+    if (!(similarity > 0.0 && similarity <= 1.0)) {
+        throw std::invalid_argument("Similarity must be in (0, 1]"s);
+    }
+    if (similarity < 1.0) {
+        // пара с мерой Жаккара s попадает в кандидаты с вероятностью
+        // 1 - (1 - s^r)^b, перелом кривой около (1/b)^(1/r)
+        band_rows_ = 1;
+        for (size_t rows = 1; rows <= SIGNATURE_SIZE; ++rows) {
+            if (SIGNATURE_SIZE % rows == 0
+                && std::pow(1.0 / (SIGNATURE_SIZE / rows), 1.0 / rows) <= similarity * BAND_THRESHOLD_MARGIN) {
+                band_rows_ = rows;
+            }
+        }
+        band_count_ = SIGNATURE_SIZE / band_rows_;
+        band_buckets_.resize(band_count_);
+    }
+}
+
+DuplicateDetector::Fingerprint DuplicateDetector::MakeFingerprint(const std::vector<std::string_view>& words) const {
+    Fingerprint fingerprint;
+    auto& unique_words = fingerprint.words;
+    unique_words = words;
+    std::sort(unique_words.begin(), unique_words.end());
+    unique_words.erase(std::unique(unique_words.begin(), unique_words.end()), unique_words.end());
+    std::vector<uint64_t> term_hashes;
+    term_hashes.reserve(unique_words.size());
+    for (const std::string_view word : unique_words) {
+        term_hashes.push_back(Mix(std::hash<std::string_view>{}(word)));
+    }
+    fingerprint.set_hash = HashRange(term_hashes.data(), term_hashes.data() + term_hashes.size());
+
+    if (band_count_ > 0) {
+        std::vector<uint64_t> signature(SIGNATURE_SIZE, std::numeric_limits<uint64_t>::max());
+        for (const uint64_t term_hash : term_hashes) {
+            for (size_t i = 0; i < SIGNATURE_SIZE; ++i) {
+                signature[i] = std::min(signature[i], Mix(term_hash + i));
+            }
+        }
+        fingerprint.band_hashes.reserve(band_count_);
+        for (size_t band = 0; band < band_count_; ++band) {
+            const uint64_t* rows = signature.data() + band * band_rows_;
+            fingerprint.band_hashes.push_back(HashRange(rows, rows + band_rows_));
+        }
+    }
+    return fingerprint;
+}
+
+int DuplicateDetector::FindDuplicate(const Fingerprint& fingerprint) const {
+    if (const auto it = set_buckets_.find(fingerprint.set_hash); it != set_buckets_.end()) {
+        for (const int document_id : it->second) {
+            if (documents_.at(document_id).words == fingerprint.words) {
+                return document_id;
+            }
+        }
+    }
+    for (size_t band = 0; band < band_count_; ++band) {
+        const auto it = band_buckets_[band].find(fingerprint.band_hashes[band]);
+        if (it == band_buckets_[band].end()) {
+            continue;
+        }
+        for (const int document_id : it->second) {
+            if (IsSimilar(documents_.at(document_id), fingerprint)) {
+                return document_id;
+            }
+        }
+    }
+    return NO_DUPLICATE;
+}
+
+void DuplicateDetector::Add(int document_id, Fingerprint fingerprint) {
+    Remove(document_id);
+    set_buckets_[fingerprint.set_hash].push_back(document_id);
+    for (size_t band = 0; band < band_count_; ++band) {
+        band_buckets_[band][fingerprint.band_hashes[band]].push_back(document_id);
+    }
+    documents_.emplace(document_id, std::move(fingerprint));
+}
+
+void DuplicateDetector::Remove(int document_id) {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        return;
+    }
+    const Fingerprint& fingerprint = it->second;
+    EraseFromBucket(set_buckets_, fingerprint.set_hash, document_id);
+    for (size_t band = 0; band < band_count_; ++band) {
+        EraseFromBucket(band_buckets_[band], fingerprint.band_hashes[band], document_id);
+    }
+    documents_.erase(it);
+}
+
+bool DuplicateDetector::IsSimilar(const Fingerprint& lhs, const Fingerprint& rhs) const {
+    const auto& a = lhs.words;
+    const auto& b = rhs.words;
+    if (a.empty() || b.empty()) {
+        return a.empty() && b.empty();
+    }
+    size_t common = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            ++i;
+        }
+        else if (b[j] < a[i]) {
+            ++j;
+        }
+        else {
+            ++common;
+            ++i;
+            ++j;
+        }
+    }
+    return common >= similarity_ * (a.size() + b.size() - common);
+}
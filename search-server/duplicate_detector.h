@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Поиск дубликатов по множествам слов документов.
+// Каждому документу строится отпечаток: его слова по алфавиту без повторов
+// и хеш всего множества. Точные дубликаты ищутся по хешу множества
+// со сверкой самих слов, так что совпадение хешей не делает документы
+// дубликатами. Если задан порог сходства меньше 1, отпечаток
+// дополняется подписью MinHash: документы с совпадающей полосой подписи
+// (LSH) становятся кандидатами и сверяются по точной мере Жаккара.
+class DuplicateDetector {
+public:
+    static constexpr int NO_DUPLICATE = -1;
+
+    struct Fingerprint {
+        // ссылаются на слова, переданные в MakeFingerprint
+        std::vector<std::string_view> words;
+        uint64_t set_hash = 0;
+        std::vector<uint64_t> band_hashes;
+    };
+
+    // similarity - наименьшая доля общих слов (мера Жаккара), при которой
+    // документ считается дубликатом; 1.0 - только совпадающие множества
+    explicit DuplicateDetector(double similarity = 1.0);
+
+    // Не меняет детектор, можно вызывать из нескольких потоков.
+    // Строки words должны жить, пока отпечаток используется или хранится.
+    Fingerprint MakeFingerprint(const std::vector<std::string_view>& words) const;
+
+    // id добавленного документа, дубликатом которого является отпечаток,
+    // или NO_DUPLICATE
+    int FindDuplicate(const Fingerprint& fingerprint) const;
+    void Add(int document_id, Fingerprint fingerprint);
+    void Remove(int document_id);
+
+private:
+    using Buckets = std::unordered_map<uint64_t, std::vector<int>>;
+
+    bool IsSimilar(const Fingerprint& lhs, const Fingerprint& rhs) const;
+
+    double similarity_;
+    size_t band_count_ = 0;
+    size_t band_rows_ = 0;
+    std::unordered_map<int, Fingerprint> documents_;
+    Buckets set_buckets_;
+    std::vector<Buckets> band_buckets_;
+};
@@ -0,0 +1,433 @@
+#include "index_segment.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_literals;
+
+namespace {
+
+const char MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+const uint32_t VERSION = 3;
+// по нему видно, что файл записан на платформе с тем же порядком байт
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t SECTION_ALIGNMENT = 8;
+const size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+enum SectionIndex {
+    STOP_WORD_OFFSETS,
+    STOP_WORD_CHARS,
+    DOCUMENT_IDS,
+    DOCUMENTS,
+    DOCUMENT_TERM_OFFSETS,
+    DOCUMENT_TERMS,
+    TERM_OFFSETS,
+    TERM_CHARS,
+    POSTING_OFFSETS,
+    POSTING_IDS,
+    POSTING_FREQS,
+    POSTING_BLOCK_OFFSETS,
+    POSTING_BLOCK_MAX_FREQS,
+    SECTION_COUNT,
+};
+
+static_assert(std::is_trivially_copyable_v<IndexSegment::DocumentData>);
+static_assert(std::is_trivially_copyable_v<IndexSegment::TermFrequency>);
+
+uint64_t AlignSection(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// count участков: смещения начинаются с нуля, не убывают и кончаются total
+bool AreValidOffsets(const uint64_t* offsets, uint64_t count, uint64_t total) {
+    if (offsets[0] != 0 || offsets[count] != total) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+struct IndexSegment::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t document_data_size;
+    uint32_t term_frequency_size;
+    uint64_t stop_word_count;
+    uint64_t stop_word_chars;
+    uint64_t document_count;
+    uint64_t word_count;
+    uint64_t document_term_count;
+    uint64_t term_count;
+    uint64_t term_chars;
+    uint64_t posting_count;
+    uint64_t posting_block_count;
+    uint64_t section_offsets[SECTION_COUNT];
+};
+
+IndexSegment::IndexSegment(const std::string& path) {
+#if !defined(_WIN32)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open index "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read index "s + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ >= sizeof(Header)) {
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map index "s + path);
+        }
+        data_ = static_cast<const char*>(mapping);
+    }
+    // отображение не зависит от дескриптора
+    close(fd);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("Cannot open index "s + path);
+    }
+    size_ = static_cast<size_t>(in.tellg());
+    buffer_ = std::make_unique<char[]>(size_);
+    in.seekg(0);
+    in.read(buffer_.get(), size_);
+    data_ = buffer_.get();
+#endif
+
+    try {
+        if (size_ < sizeof(Header)) {
+            throw std::runtime_error("Index "s + path + " is truncated"s);
+        }
+        header_ = reinterpret_cast<const Header*>(data_);
+        if (std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0
+            || header_->version != VERSION
+            || header_->byte_order_mark != BYTE_ORDER_MARK
+            || header_->document_data_size != sizeof(DocumentData)
+            || header_->term_frequency_size != sizeof(TermFrequency)) {
+            throw std::runtime_error("Index "s + path + " has unsupported format"s);
+        }
+
+        const uint64_t* offsets = header_->section_offsets;
+        stop_word_offsets_ = GetSection<uint64_t>(offsets[STOP_WORD_OFFSETS], header_->stop_word_count + 1);
+        stop_word_chars_ = GetSection<char>(offsets[STOP_WORD_CHARS], header_->stop_word_chars);
+        document_ids_ = GetSection<int>(offsets[DOCUMENT_IDS], header_->document_count);
+        documents_ = GetSection<DocumentData>(offsets[DOCUMENTS], header_->document_count);
+        document_term_offsets_ = GetSection<uint64_t>(offsets[DOCUMENT_TERM_OFFSETS], header_->document_count + 1);
+        document_terms_ = GetSection<TermFrequency>(offsets[DOCUMENT_TERMS], header_->document_term_count);
+        term_offsets_ = GetSection<uint64_t>(offsets[TERM_OFFSETS], header_->term_count + 1);
+        term_chars_ = GetSection<char>(offsets[TERM_CHARS], header_->term_chars);
+        posting_offsets_ = GetSection<uint64_t>(offsets[POSTING_OFFSETS], header_->term_count + 1);
+        posting_ids_ = GetSection<int>(offsets[POSTING_IDS], header_->posting_count);
+        posting_freqs_ = GetSection<double>(offsets[POSTING_FREQS], header_->posting_count);
+        posting_block_offsets_ = GetSection<uint64_t>(offsets[POSTING_BLOCK_OFFSETS], header_->term_count + 1);
+        posting_block_max_freqs_ = GetSection<double>(offsets[POSTING_BLOCK_MAX_FREQS], header_->posting_block_count);
+
+        if (!IsConsistent()) {
+            throw std::runtime_error("Index "s + path + " is corrupted"s);
+        }
+    }
+    catch (...) {
+#if !defined(_WIN32)
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        throw;
+    }
+}
+
+bool IndexSegment::IsConsistent() const {
+    const uint64_t document_count = header_->document_count;
+    const uint64_t term_count = header_->term_count;
+    if (document_count > static_cast<uint64_t>(std::numeric_limits<int>::max())
+        || term_count >= NO_TERM
+        || !AreValidOffsets(stop_word_offsets_, header_->stop_word_count, header_->stop_word_chars)
+        || !AreValidOffsets(document_term_offsets_, document_count, header_->document_term_count)
+        || !AreValidOffsets(term_offsets_, term_count, header_->term_chars)
+        || !AreValidOffsets(posting_offsets_, term_count, header_->posting_count)
+        || !AreValidOffsets(posting_block_offsets_, term_count, header_->posting_block_count)) {
+        return false;
+    }
+
+    // id документов возрастают, статус служит индексом частей списков
+    for (uint64_t ordinal = 0; ordinal < document_count; ++ordinal) {
+        const DocumentData& document = documents_[ordinal];
+        if (document_ids_[ordinal] < 0 || (ordinal > 0 && document_ids_[ordinal - 1] >= document_ids_[ordinal])
+            || static_cast<uint32_t>(document.status) > static_cast<uint32_t>(DocumentStatus::REMOVED)
+            || document.word_count < 0) {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header_->document_term_count; ++i) {
+        if (document_terms_[i].term_id >= term_count) {
+            return false;
+        }
+    }
+    // вхождения слова - возрастающие порядковые номера документов
+    for (uint64_t term_id = 0; term_id < term_count; ++term_id) {
+        const uint64_t first = posting_offsets_[term_id];
+        const uint64_t last = posting_offsets_[term_id + 1];
+        if (posting_block_offsets_[term_id + 1] - posting_block_offsets_[term_id] != GetPostingBlockCount(last - first)) {
+            return false;
+        }
+        int previous = -1;
+        for (uint64_t i = first; i < last; ++i) {
+            if (posting_ids_[i] <= previous || static_cast<uint64_t>(posting_ids_[i]) >= document_count) {
+                return false;
+            }
+            previous = posting_ids_[i];
+        }
+    }
+    return true;
+}
+
+IndexSegment::~IndexSegment() {
+#if !defined(_WIN32)
+    munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+size_t IndexSegment::GetStopWordCount() const {
+    return header_->stop_word_count;
+}
+
+std::string_view IndexSegment::GetStopWord(size_t index) const {
+    return GetString(stop_word_offsets_, stop_word_chars_, index);
+}
+
+int IndexSegment::GetDocumentCount() const {
+    return static_cast<int>(header_->document_count);
+}
+
+uint64_t IndexSegment::GetWordCount() const {
+    return header_->word_count;
+}
+
+int IndexSegment::FindDocument(int document_id) const {
+    const int* end = document_ids_ + header_->document_count;
+    const int* it = std::lower_bound(document_ids_, end, document_id);
+    return it != end && *it == document_id ? static_cast<int>(it - document_ids_) : -1;
+}
+
+const int* IndexSegment::GetDocumentIds() const {
+    return document_ids_;
+}
+
+const IndexSegment::DocumentData* IndexSegment::GetDocuments() const {
+    return documents_;
+}
+
+ArrayView<IndexSegment::TermFrequency> IndexSegment::GetDocumentTerms(int ordinal) const {
+    const uint64_t first = document_term_offsets_[ordinal];
+    return { document_terms_ + first, document_term_offsets_[ordinal + 1] - first };
+}
+
+uint32_t IndexSegment::GetTermCount() const {
+    return static_cast<uint32_t>(header_->term_count);
+}
+
+uint32_t IndexSegment::FindTerm(std::string_view word) const {
+    uint32_t first = 0;
+    uint32_t last = GetTermCount();
+    while (first < last) {
+        const uint32_t middle = first + (last - first) / 2;
+        if (GetTerm(middle) < word) {
+            first = middle + 1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    return first < GetTermCount() && GetTerm(first) == word ? first : NO_TERM;
+}
+
+std::string_view IndexSegment::GetTerm(uint32_t term_id) const {
+    return GetString(term_offsets_, term_chars_, term_id);
+}
+
+ArrayView<int> IndexSegment::GetPostingIds(uint32_t term_id) const {
+    const uint64_t first = posting_offsets_[term_id];
+    return { posting_ids_ + first, posting_offsets_[term_id + 1] - first };
+}
+
+ArrayView<double> IndexSegment::GetPostingFreqs(uint32_t term_id) const {
+    const uint64_t first = posting_offsets_[term_id];
+    return { posting_freqs_ + first, posting_offsets_[term_id + 1] - first };
+}
+
+ArrayView<double> IndexSegment::GetPostingBlockMaxFreqs(uint32_t term_id) const {
+    const uint64_t first = posting_block_offsets_[term_id];
+    return { posting_block_max_freqs_ + first, posting_block_offsets_[term_id + 1] - first };
+}
+
+uint64_t IndexSegment::GetPostingBlockCount(uint64_t posting_count) {
+    return (posting_count + POSTING_BLOCK_SIZE - 1) / POSTING_BLOCK_SIZE;
+}
+
+template <typename T>
+const T* IndexSegment::GetSection(uint64_t offset, uint64_t count) const {
+    if (offset % alignof(T) != 0 || offset > size_ || count > (size_ - offset) / sizeof(T)) {
+        throw std::runtime_error("Index section is out of file bounds"s);
+    }
+    return reinterpret_cast<const T*>(data_ + offset);
+}
+
+std::string_view IndexSegment::GetString(const uint64_t* offsets, const char* chars, size_t index) const {
+    return { chars + offsets[index], offsets[index + 1] - offsets[index] };
+}
+
+IndexSegmentWriter::IndexSegmentWriter(const std::string& path, const Sizes& sizes)
+    : path_(path)
+    , temp_path_(path + ".tmp"s)
+    , out_(temp_path_, std::ios::binary | std::ios::trunc)
+    , sizes_(sizes)
+    , sections_(SECTION_COUNT) {
+    if (!out_) {
+        throw std::runtime_error("Cannot create index "s + temp_path_);
+    }
+    const uint64_t section_bytes[SECTION_COUNT] = {
+        (sizes.stop_word_count + 1) * sizeof(uint64_t),
+        sizes.stop_word_chars,
+        sizes.document_count * sizeof(int),
+        sizes.document_count * sizeof(IndexSegment::DocumentData),
+        (sizes.document_count + 1) * sizeof(uint64_t),
+        sizes.document_term_count * sizeof(IndexSegment::TermFrequency),
+        (sizes.term_count + 1) * sizeof(uint64_t),
+        sizes.term_chars,
+        (sizes.term_count + 1) * sizeof(uint64_t),
+        sizes.posting_count * sizeof(int),
+        sizes.posting_count * sizeof(double),
+        (sizes.term_count + 1) * sizeof(uint64_t),
+        sizes.posting_block_count * sizeof(double),
+    };
+    uint64_t offset = AlignSection(sizeof(IndexSegment::Header));
+    for (size_t i = 0; i < SECTION_COUNT; ++i) {
+        sections_[i].offset = offset;
+        offset = AlignSection(offset + section_bytes[i]);
+    }
+    file_size_ = offset;
+
+    // списки смещений начинаются с нуля
+    const uint64_t zero = 0;
+    Append(STOP_WORD_OFFSETS, &zero, 1);
+    Append(DOCUMENT_TERM_OFFSETS, &zero, 1);
+    Append(TERM_OFFSETS, &zero, 1);
+    Append(POSTING_OFFSETS, &zero, 1);
+    Append(POSTING_BLOCK_OFFSETS, &zero, 1);
+}
+
+void IndexSegmentWriter::WriteStopWord(std::string_view word) {
+    Append(STOP_WORD_CHARS, word.data(), word.size());
+    stop_word_chars_ += word.size();
+    Append(STOP_WORD_OFFSETS, &stop_word_chars_, 1);
+}
+
+void IndexSegmentWriter::WriteDocument(int document_id, const IndexSegment::DocumentData& data,
+    const std::vector<IndexSegment::TermFrequency>& terms) {
+    Append(DOCUMENT_IDS, &document_id, 1);
+    Append(DOCUMENTS, &data, 1);
+    Append(DOCUMENT_TERMS, terms.data(), terms.size());
+    document_terms_ += terms.size();
+    Append(DOCUMENT_TERM_OFFSETS, &document_terms_, 1);
+}
+
+void IndexSegmentWriter::WriteTerm(std::string_view term, const std::vector<int>& posting_ids,
+    const std::vector<double>& posting_freqs) {
+    Append(TERM_CHARS, term.data(), term.size());
+    term_chars_ += term.size();
+    Append(TERM_OFFSETS, &term_chars_, 1);
+    Append(POSTING_IDS, posting_ids.data(), posting_ids.size());
+    Append(POSTING_FREQS, posting_freqs.data(), posting_freqs.size());
+    postings_ += posting_ids.size();
+    Append(POSTING_OFFSETS, &postings_, 1);
+
+    block_max_freqs_.clear();
+    for (size_t i = 0; i < posting_freqs.size(); i += IndexSegment::POSTING_BLOCK_SIZE) {
+        const auto last = posting_freqs.begin() + std::min(i + IndexSegment::POSTING_BLOCK_SIZE, posting_freqs.size());
+        block_max_freqs_.push_back(*std::max_element(posting_freqs.begin() + i, last));
+    }
+    Append(POSTING_BLOCK_MAX_FREQS, block_max_freqs_.data(), block_max_freqs_.size());
+    posting_blocks_ += block_max_freqs_.size();
+    Append(POSTING_BLOCK_OFFSETS, &posting_blocks_, 1);
+}
+
+void IndexSegmentWriter::Finish() {
+    if (stop_word_chars_ != sizes_.stop_word_chars || document_terms_ != sizes_.document_term_count
+        || term_chars_ != sizes_.term_chars || postings_ != sizes_.posting_count
+        || posting_blocks_ != sizes_.posting_block_count) {
+        throw std::logic_error("Index sections do not match declared sizes"s);
+    }
+    // пустые секции в конце тоже должны лежать в пределах файла
+    out_.seekp(file_size_ - 1);
+    out_.put('\0');
+    for (Section& section : sections_) {
+        Flush(section);
+    }
+
+    IndexSegment::Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order_mark = BYTE_ORDER_MARK;
+    header.document_data_size = sizeof(IndexSegment::DocumentData);
+    header.term_frequency_size = sizeof(IndexSegment::TermFrequency);
+    header.stop_word_count = sizes_.stop_word_count;
+    header.stop_word_chars = sizes_.stop_word_chars;
+    header.document_count = sizes_.document_count;
+    header.word_count = sizes_.word_count;
+    header.document_term_count = sizes_.document_term_count;
+    header.term_count = sizes_.term_count;
+    header.term_chars = sizes_.term_chars;
+    header.posting_count = sizes_.posting_count;
+    header.posting_block_count = sizes_.posting_block_count;
+    for (size_t i = 0; i < SECTION_COUNT; ++i) {
+        header.section_offsets[i] = sections_[i].offset;
+    }
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Cannot write index "s + temp_path_);
+    }
+    if (std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace index "s + path_);
+    }
+}
+
+template <typename T>
+void IndexSegmentWriter::Append(size_t section_index, const T* data, size_t count) {
+    Section& section = sections_[section_index];
+    const char* bytes = reinterpret_cast<const char*>(data);
+    section.buffer.insert(section.buffer.end(), bytes, bytes + count * sizeof(T));
+    if (section.buffer.size() >= WRITE_BUFFER_SIZE) {
+        Flush(section);
+    }
+}
+
+void IndexSegmentWriter::Flush(Section& section) {
+    if (section.buffer.empty()) {
+        return;
+    }
+    out_.seekp(section.offset + section.written);
+    out_.write(section.buffer.data(), section.buffer.size());
+    section.written += section.buffer.size();
+    section.buffer.clear();
+}
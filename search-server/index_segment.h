@@ -0,0 +1,182 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+
+// непрерывный участок массива, которым диапазон не владеет
+template <typename T>
+class ArrayView {
+public:
+    ArrayView() = default;
+
+    ArrayView(const T* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+
+    const T* begin() const {
+        return data_;
+    }
+
+    const T* end() const {
+        return data_ + size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+
+private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Сохранённый индекс, отображённый в память только для чтения.
+// Данные используются прямо из отображения без разбора и копирования,
+// страницы подгружаются системой при первом обращении.
+// Документы хранятся по возрастанию id, их порядковый номер - позиция
+// в файле; слова хранятся по алфавиту, id слова - его позиция.
+// Формат зависит от платформы: файл читается той же сборкой, что его записала.
+class IndexSegment {
+public:
+    static constexpr uint32_t NO_TERM = std::numeric_limits<uint32_t>::max();
+    // для каждых POSTING_BLOCK_SIZE вхождений слова хранится их наибольшая частота
+    static constexpr size_t POSTING_BLOCK_SIZE = 128;
+
+    struct DocumentData {
+        int rating;
+        DocumentStatus status;
+        // число слов документа без стоп-слов
+        int word_count;
+    };
+
+    struct TermFrequency {
+        uint32_t term_id;
+        double term_freq;
+    };
+
+    // Бросает runtime_error, если файл не открывается или повреждён:
+    // при открытии проверяются все таблицы смещений и диапазоны id
+    // документов, слов и вхождений, поэтому открытие читает весь файл.
+    explicit IndexSegment(const std::string& path);
+    ~IndexSegment();
+
+    IndexSegment(const IndexSegment&) = delete;
+    IndexSegment& operator=(const IndexSegment&) = delete;
+
+    size_t GetStopWordCount() const;
+    std::string_view GetStopWord(size_t index) const;
+
+    int GetDocumentCount() const;
+    // сумма word_count всех документов
+    uint64_t GetWordCount() const;
+    // порядковый номер документа или -1
+    int FindDocument(int document_id) const;
+    // массивы по порядковому номеру
+    const int* GetDocumentIds() const;
+    const DocumentData* GetDocuments() const;
+    ArrayView<TermFrequency> GetDocumentTerms(int ordinal) const;
+
+    uint32_t GetTermCount() const;
+    uint32_t FindTerm(std::string_view word) const;
+    std::string_view GetTerm(uint32_t term_id) const;
+    ArrayView<int> GetPostingIds(uint32_t term_id) const;
+    ArrayView<double> GetPostingFreqs(uint32_t term_id) const;
+    ArrayView<double> GetPostingBlockMaxFreqs(uint32_t term_id) const;
+
+    static uint64_t GetPostingBlockCount(uint64_t posting_count);
+
+private:
+    friend class IndexSegmentWriter;
+    struct Header;
+
+    template <typename T>
+    const T* GetSection(uint64_t offset, uint64_t count) const;
+
+    std::string_view GetString(const uint64_t* offsets, const char* chars, size_t index) const;
+    // все смещения и id в пределах своих секций
+    bool IsConsistent() const;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    // буфер, если отображение файлов недоступно
+    std::unique_ptr<char[]> buffer_;
+
+    const Header* header_ = nullptr;
+    const uint64_t* stop_word_offsets_ = nullptr;
+    const char* stop_word_chars_ = nullptr;
+    const int* document_ids_ = nullptr;
+    const DocumentData* documents_ = nullptr;
+    const uint64_t* document_term_offsets_ = nullptr;
+    const TermFrequency* document_terms_ = nullptr;
+    const uint64_t* term_offsets_ = nullptr;
+    const char* term_chars_ = nullptr;
+    const uint64_t* posting_offsets_ = nullptr;
+    const int* posting_ids_ = nullptr;
+    const double* posting_freqs_ = nullptr;
+    const uint64_t* posting_block_offsets_ = nullptr;
+    const double* posting_block_max_freqs_ = nullptr;
+};
+
+// Записывает файл индекса. Размеры секций известны заранее, поэтому
+// каждая секция пишется сразу на своё место небольшими порциями.
+// Файл собирается под временным именем и заменяет path в Finish,
+// так что уже отображённый старый файл остаётся целым.
+class IndexSegmentWriter {
+public:
+    struct Sizes {
+        uint64_t stop_word_count = 0;
+        uint64_t stop_word_chars = 0;
+        uint64_t document_count = 0;
+        uint64_t word_count = 0;
+        uint64_t document_term_count = 0;
+        uint64_t term_count = 0;
+        uint64_t term_chars = 0;
+        uint64_t posting_count = 0;
+        // сумма GetPostingBlockCount по словам
+        uint64_t posting_block_count = 0;
+    };
+
+    IndexSegmentWriter(const std::string& path, const Sizes& sizes);
+
+    // стоп-слова, документы и слова пишутся в порядке хранения в файле
+    void WriteStopWord(std::string_view word);
+    void WriteDocument(int document_id, const IndexSegment::DocumentData& data,
+        const std::vector<IndexSegment::TermFrequency>& terms);
+    void WriteTerm(std::string_view term, const std::vector<int>& posting_ids,
+        const std::vector<double>& posting_freqs);
+    void Finish();
+
+private:
+    struct Section {
+        uint64_t offset = 0;
+        uint64_t written = 0;
+        std::vector<char> buffer;
+    };
+
+    template <typename T>
+    void Append(size_t section, const T* data, size_t count);
+    void Flush(Section& section);
+
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+    Sizes sizes_;
+    std::vector<Section> sections_;
+    uint64_t file_size_ = 0;
+    uint64_t stop_word_chars_ = 0;
+    uint64_t document_terms_ = 0;
+    uint64_t term_chars_ = 0;
+    uint64_t postings_ = 0;
+    uint64_t posting_blocks_ = 0;
+    std::vector<double> block_max_freqs_;
+};
@@ -0,0 +1,500 @@
+#include "inverted_index.h"
+#include <algorithm>
+
+PostingList::PostingList(ArrayView<int> document_ids, ArrayView<double> term_freqs, ArrayView<double> block_max_freqs)
+    : external_ids_(document_ids)
+    , external_freqs_(term_freqs)
+    , external_block_max_freqs_(block_max_freqs)
+    , is_external_(true) {
+    for (const double max_freq : block_max_freqs) {
+        external_max_freq_ = std::max(external_max_freq_, max_freq);
+    }
+}
+
+void PostingList::Add(int document_id, double term_freq) {
+    if (!is_external_ && pending_ids_.empty() && (blocks_.Empty() || blocks_.GetLastId() < document_id)) {
+        blocks_.Append(document_id, term_freq);
+        return;
+    }
+    const auto it = std::lower_bound(pending_ids_.begin(), pending_ids_.end(), document_id);
+    const auto pos = it - pending_ids_.begin();
+    pending_ids_.insert(it, document_id);
+    pending_freqs_.insert(pending_freqs_.begin() + pos, term_freq);
+    pending_max_freq_ = std::max(pending_max_freq_, term_freq);
+
+    if (pending_ids_.size() > std::max(MIN_PENDING_SIZE, GetMainSize() / 8)) {
+        Merge();
+    }
+}
+
+bool PostingList::Remove(int document_id) {
+    if (is_external_ && std::binary_search(external_ids_.begin(), external_ids_.end(), document_id)) {
+        Detach();
+    }
+    if (!is_external_ && blocks_.Remove(document_id)) {
+        return true;
+    }
+    const auto it = std::lower_bound(pending_ids_.begin(), pending_ids_.end(), document_id);
+    if (it != pending_ids_.end() && *it == document_id) {
+        pending_freqs_.erase(pending_freqs_.begin() + (it - pending_ids_.begin()));
+        pending_ids_.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void PostingList::RemoveSorted(const std::vector<int>& document_ids) {
+    // удаление одного вхождения перекодирует блок и сдвигает все следующие
+    if (document_ids.size() <= MAX_SINGLE_REMOVALS) {
+        for (const int document_id : document_ids) {
+            Remove(document_id);
+        }
+        return;
+    }
+    std::vector<int> ids;
+    std::vector<double> freqs;
+    ids.reserve(Size());
+    freqs.reserve(Size());
+    size_t position = 0;
+    ForEach([&](int document_id, double term_freq) {
+        position = GallopLowerBound(document_ids.begin() + position, document_ids.end(), document_id) - document_ids.begin();
+        if (position == document_ids.size() || document_ids[position] != document_id) {
+            ids.push_back(document_id);
+            freqs.push_back(term_freq);
+        }
+        });
+    Assign(ids, freqs);
+}
+
+bool PostingList::Contains(int document_id) const {
+    const bool in_main = is_external_
+        ? std::binary_search(external_ids_.begin(), external_ids_.end(), document_id)
+        : blocks_.Contains(document_id);
+    return in_main || std::binary_search(pending_ids_.begin(), pending_ids_.end(), document_id);
+}
+
+size_t PostingList::Size() const {
+    return GetMainSize() + pending_ids_.size();
+}
+
+bool PostingList::Empty() const {
+    return Size() == 0;
+}
+
+void PostingList::Merge() {
+    if (pending_ids_.empty()) {
+        return;
+    }
+    std::vector<int> ids;
+    std::vector<double> freqs;
+    ids.reserve(Size());
+    freqs.reserve(Size());
+    ForEach([&ids, &freqs](int document_id, double term_freq) {
+        ids.push_back(document_id);
+        freqs.push_back(term_freq);
+        });
+    Assign(ids, freqs);
+}
+
+size_t PostingList::GetMemoryBytes() const {
+    return blocks_.GetMemoryBytes() + pending_ids_.capacity() * sizeof(int) + pending_freqs_.capacity() * sizeof(double);
+}
+
+double PostingList::GetMaxTermFreq() const {
+    return std::max(is_external_ ? external_max_freq_ : blocks_.GetMaxFreq(), pending_max_freq_);
+}
+
+size_t PostingList::GetMainSize() const {
+    return is_external_ ? external_ids_.size() : blocks_.Size();
+}
+
+void PostingList::Assign(const std::vector<int>& ids, const std::vector<double>& freqs) {
+    blocks_.Assign(ids.data(), freqs.data(), ids.size());
+    external_ids_ = {};
+    external_freqs_ = {};
+    external_block_max_freqs_ = {};
+    is_external_ = false;
+    pending_ids_.clear();
+    pending_freqs_.clear();
+    pending_max_freq_ = 0.0;
+}
+
+void PostingList::Detach() {
+    if (!is_external_) {
+        return;
+    }
+    blocks_.Assign(external_ids_.begin(), external_freqs_.begin(), external_ids_.size());
+    external_ids_ = {};
+    external_freqs_ = {};
+    external_block_max_freqs_ = {};
+    is_external_ = false;
+}
+
+PostingList::Seeker::Seeker(const PostingList& postings)
+    : postings_(postings)
+    , blocks_(postings.blocks_) {
+}
+
+bool PostingList::Seeker::Contains(int document_id) {
+    bool in_main;
+    if (postings_.is_external_) {
+        const ArrayView<int>& ids = postings_.external_ids_;
+        external_position_ = GallopLowerBound(ids.begin() + external_position_, ids.end(), document_id) - ids.begin();
+        in_main = external_position_ < ids.size() && ids[external_position_] == document_id;
+    }
+    else {
+        in_main = blocks_.Contains(document_id);
+    }
+    if (in_main) {
+        return true;
+    }
+    const auto& pending = postings_.pending_ids_;
+    pending_position_ = GallopLowerBound(pending.begin() + pending_position_, pending.end(), document_id) - pending.begin();
+    return pending_position_ < pending.size() && pending[pending_position_] == document_id;
+}
+
+PostingList::Cursor::Cursor(const PostingList& postings, int first)
+    : postings_(postings)
+    , blocks_(postings.blocks_) {
+    Advance(first);
+}
+
+void PostingList::Cursor::Seek(int document_id) {
+    ShallowAdvance(document_id);
+    int main_id = END;
+    double main_freq = 0.0;
+    if (postings_.is_external_) {
+        if (external_position_ < postings_.external_ids_.size()) {
+            main_id = postings_.external_ids_[external_position_];
+            main_freq = postings_.external_freqs_[external_position_];
+        }
+    }
+    else {
+        blocks_.Advance(document_id);
+        main_id = blocks_.GetId();
+        main_freq = blocks_.GetFreq();
+    }
+    const auto& pending = postings_.pending_ids_;
+    pending_position_ = GallopLowerBound(pending.begin() + pending_position_, pending.end(), document_id) - pending.begin();
+    if (pending_position_ < pending.size() && pending[pending_position_] < main_id) {
+        document_id_ = pending[pending_position_];
+        term_freq_ = postings_.pending_freqs_[pending_position_];
+    }
+    else {
+        document_id_ = main_id;
+        term_freq_ = main_freq;
+    }
+}
+
+void PostingList::Cursor::ShallowAdvance(int document_id) {
+    if (postings_.is_external_) {
+        // несжатые вхождения ищутся сразу, раскодировать нечего
+        const ArrayView<int>& ids = postings_.external_ids_;
+        external_position_ = GallopLowerBound(ids.begin() + external_position_, ids.end(), document_id) - ids.begin();
+    }
+    else {
+        blocks_.ShallowAdvance(document_id);
+    }
+}
+
+int PostingList::Cursor::GetBlockLastId() const {
+    if (!postings_.is_external_) {
+        return blocks_.GetBlockLastId();
+    }
+    const size_t size = postings_.external_ids_.size();
+    if (external_position_ == size) {
+        return END;
+    }
+    const size_t block_end = (external_position_ / IndexSegment::POSTING_BLOCK_SIZE + 1) * IndexSegment::POSTING_BLOCK_SIZE;
+    return postings_.external_ids_[std::min(block_end, size) - 1];
+}
+
+double PostingList::Cursor::GetBlockMaxFreq() const {
+    double max_freq = 0.0;
+    if (!postings_.is_external_) {
+        max_freq = blocks_.GetBlockMaxFreq();
+    }
+    else if (external_position_ < postings_.external_ids_.size()) {
+        max_freq = postings_.external_block_max_freqs_[external_position_ / IndexSegment::POSTING_BLOCK_SIZE];
+    }
+    if (pending_position_ < postings_.pending_ids_.size()) {
+        max_freq = std::max(max_freq, postings_.pending_max_freq_);
+    }
+    return max_freq;
+}
+
+StatusPostings::StatusPostings(PostingList unsplit) {
+    if (!unsplit.Empty()) {
+        parts_.push_back({ UNSPLIT, std::move(unsplit) });
+    }
+}
+
+void StatusPostings::Add(int document_id, double term_freq, DocumentStatus status) {
+    GetPartToAdd(GetKey(status)).Add(document_id, term_freq);
+}
+
+bool StatusPostings::Remove(int document_id, DocumentStatus status) {
+    for (const uint8_t key : { GetKey(status), UNSPLIT }) {
+        PostingList* postings = FindPart(key);
+        if (postings != nullptr && postings->Remove(document_id)) {
+            EraseEmptyParts();
+            return true;
+        }
+    }
+    return false;
+}
+
+void StatusPostings::RemoveSorted(const std::vector<int>& document_ids) {
+    // часть получает только свои документы, части без удаляемых
+    // документов не пересобираются
+    std::vector<int> part_ids;
+    for (Part& part : parts_) {
+        part_ids.clear();
+        PostingList::Seeker seeker(part.postings);
+        for (const int document_id : document_ids) {
+            if (seeker.Contains(document_id)) {
+                part_ids.push_back(document_id);
+            }
+        }
+        if (!part_ids.empty()) {
+            part.postings.RemoveSorted(part_ids);
+        }
+    }
+    EraseEmptyParts();
+}
+
+void StatusPostings::Move(int document_id, double term_freq, DocumentStatus from, DocumentStatus to) {
+    if (Remove(document_id, from)) {
+        Add(document_id, term_freq, to);
+    }
+}
+
+bool StatusPostings::Contains(int document_id, DocumentStatus status) const {
+    for (const uint8_t key : { GetKey(status), UNSPLIT }) {
+        const PostingList* postings = FindPart(key);
+        if (postings != nullptr && postings->Contains(document_id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t StatusPostings::Size() const {
+    size_t size = 0;
+    for (const Part& part : parts_) {
+        size += part.postings.Size();
+    }
+    return size;
+}
+
+bool StatusPostings::Empty() const {
+    return parts_.empty();
+}
+
+size_t StatusPostings::GetMemoryBytes() const {
+    size_t bytes = parts_.capacity() * sizeof(Part);
+    for (const Part& part : parts_) {
+        bytes += part.postings.GetMemoryBytes();
+    }
+    return bytes;
+}
+
+uint8_t StatusPostings::GetKey(DocumentStatus status) {
+    return static_cast<uint8_t>(status);
+}
+
+PostingList* StatusPostings::FindPart(uint8_t key) {
+    for (Part& part : parts_) {
+        if (part.status == key) {
+            return &part.postings;
+        }
+    }
+    return nullptr;
+}
+
+const PostingList* StatusPostings::FindPart(uint8_t key) const {
+    for (const Part& part : parts_) {
+        if (part.status == key) {
+            return &part.postings;
+        }
+    }
+    return nullptr;
+}
+
+PostingList& StatusPostings::GetPartToAdd(uint8_t key) {
+    if (PostingList* postings = FindPart(key)) {
+        return *postings;
+    }
+    parts_.push_back({ key, PostingList() });
+    return parts_.back().postings;
+}
+
+void StatusPostings::EraseEmptyParts() {
+    parts_.erase(std::remove_if(parts_.begin(), parts_.end(), [](const Part& part) {
+        return part.postings.Empty();
+        }), parts_.end());
+}
+
+StatusPostings::Seeker::Seeker(const StatusPostings& postings)
+    : postings_(postings) {
+    seekers_.reserve(postings.parts_.size());
+    for (const Part& part : postings.parts_) {
+        seekers_.emplace_back(part.postings);
+    }
+}
+
+bool StatusPostings::Seeker::Contains(int document_id, DocumentStatus status) {
+    const uint8_t key = GetKey(status);
+    for (size_t i = 0; i < seekers_.size(); ++i) {
+        const uint8_t part_status = postings_.parts_[i].status;
+        if ((part_status == key || part_status == UNSPLIT) && seekers_[i].Contains(document_id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+InvertedIndex::InvertedIndex(std::shared_ptr<const IndexSegment> segment)
+    : segment_(std::move(segment))
+    , segment_term_count_(segment_->GetTermCount()) {
+}
+
+uint32_t InvertedIndex::FindTermId(std::string_view word) const {
+    const uint32_t* term_id = term_ids_.Find(word);
+    if (term_id != nullptr) {
+        return *term_id;
+    }
+    return segment_ ? segment_->FindTerm(word) : NO_TERM;
+}
+
+std::string_view InvertedIndex::GetTerm(uint32_t term_id) const {
+    return IsSegmentTerm(term_id) ? segment_->GetTerm(term_id) : terms_[term_id - segment_term_count_];
+}
+
+const StatusPostings* InvertedIndex::Find(std::string_view word) const {
+    const uint32_t term_id = FindTermId(word);
+    if (term_id == NO_TERM) {
+        return nullptr;
+    }
+    const StatusPostings& postings = GetPostings(term_id);
+    return postings.Empty() ? nullptr : &postings;
+}
+
+const StatusPostings& InvertedIndex::GetPostings(uint32_t term_id) const {
+    return IsSegmentTerm(term_id) ? GetSegmentPostings(term_id) : *postings_[term_id - segment_term_count_];
+}
+
+StatusPostings& InvertedIndex::GetMutablePostings(uint32_t term_id) {
+    if (!IsSegmentTerm(term_id)) {
+        return postings_.Mutable(term_id - segment_term_count_).Mutable();
+    }
+    if (CowPtr<StatusPostings>* postings = segment_postings_.FindMutable(term_id)) {
+        return postings->Mutable();
+    }
+    StatusPostings view(PostingList(segment_->GetPostingIds(term_id), segment_->GetPostingFreqs(term_id),
+        segment_->GetPostingBlockMaxFreqs(term_id)));
+    return segment_postings_.Emplace(term_id, CowPtr<StatusPostings>(std::move(view))).first->second.Mutable();
+}
+
+uint32_t InvertedIndex::Add(std::string_view word, int document_id, double term_freq, DocumentStatus status) {
+    const uint32_t term_id = AddTerm(word);
+    GetPostingsToAdd(term_id).Add(document_id, term_freq, status);
+    return term_id;
+}
+
+uint32_t InvertedIndex::AddTerm(std::string_view word) {
+    uint32_t term_id = FindTermId(word);
+    if (term_id != NO_TERM) {
+        return term_id;
+    }
+    const std::string_view term = arena_->Store(word);
+    uint32_t index;
+    if (!free_term_ids_.empty()) {
+        index = free_term_ids_.back();
+        free_term_ids_.pop_back();
+        terms_.Mutable(index) = term;
+    }
+    else {
+        index = static_cast<uint32_t>(terms_.size());
+        terms_.push_back(term);
+        postings_.push_back({});
+    }
+    term_id = segment_term_count_ + index;
+    term_ids_.Emplace(term, term_id);
+    ++empty_term_count_;
+    return term_id;
+}
+
+StatusPostings& InvertedIndex::GetPostingsToAdd(uint32_t term_id) {
+    StatusPostings& postings = GetMutablePostings(term_id);
+    if (postings.Empty()) {
+        --empty_term_count_;
+        if (IsSegmentTerm(term_id)) {
+            --empty_segment_term_count_;
+        }
+    }
+    return postings;
+}
+
+void InvertedIndex::Remove(uint32_t term_id, int document_id, DocumentStatus status) {
+    StatusPostings& postings = GetMutablePostings(term_id);
+    if (postings.Remove(document_id, status) && postings.Empty()) {
+        OnPostingsEmptied(term_id);
+    }
+}
+
+void InvertedIndex::OnPostingsEmptied(uint32_t term_id) {
+    ++empty_term_count_;
+    if (IsSegmentTerm(term_id)) {
+        ++empty_segment_term_count_;
+    }
+}
+
+size_t InvertedIndex::TermCount() const {
+    return segment_term_count_ + term_ids_.size() - empty_term_count_;
+}
+
+bool InvertedIndex::NeedsCompaction() const {
+    return empty_term_count_ - empty_segment_term_count_ > std::max(MIN_COMPACTION_TERMS, TermCount());
+}
+
+void InvertedIndex::Compact() {
+    // старая арена остаётся жить, пока на неё ссылаются копии индекса
+    auto arena = std::make_shared<TermArena>();
+    CowHashMap<std::string_view, uint32_t> term_ids;
+    for (uint32_t index = 0; index < terms_.size(); ++index) {
+        if (terms_[index].data() == nullptr) {
+            continue;
+        }
+        if (postings_[index]->Empty()) {
+            terms_.Mutable(index) = {};
+            postings_.Mutable(index) = {};
+            free_term_ids_.push_back(index);
+        }
+        else {
+            terms_.Mutable(index) = arena->Store(terms_[index]);
+            term_ids.Emplace(terms_[index], segment_term_count_ + index);
+        }
+    }
+    arena_ = std::move(arena);
+    term_ids_ = std::move(term_ids);
+    empty_term_count_ = empty_segment_term_count_;
+}
+
+std::shared_ptr<const TermArena> InvertedIndex::GetArena() const {
+    return arena_;
+}
+
+bool InvertedIndex::IsSegmentTerm(uint32_t term_id) const {
+    return term_id < segment_term_count_;
+}
+
+const StatusPostings& InvertedIndex::GetSegmentPostings(uint32_t term_id) const {
+    if (const CowPtr<StatusPostings>* postings = segment_postings_.Find(term_id)) {
+        return **postings;
+    }
+    return segment_views_.Get(term_id, [this, term_id]() {
+        return StatusPostings(PostingList(segment_->GetPostingIds(term_id), segment_->GetPostingFreqs(term_id),
+            segment_->GetPostingBlockMaxFreqs(term_id)));
+        });
+}
@@ -0,0 +1,357 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "copy_on_write.h"
+#include "document.h"
+#include "index_segment.h"
+#include "posting_blocks.h"
+#include "term_arena.h"
+
+// Список вхождений слова, отсортированный по document_id.
+// Основная часть хранится сжатыми блоками (см. PostingBlocks); документы,
+// добавленные не по возрастанию id, копятся в небольшом отсортированном
+// буфере и периодически сливаются с основной частью.
+// Основная часть может лежать во внешней памяти (отображённом файле
+// индекса): новые вхождения тогда копятся в буфере, а сама часть
+// сжимается в память при удалении или слиянии.
+// Для отсечения при поиске лучших документов список знает наибольшую
+// частоту слова целиком и по блокам основной части.
+class PostingList {
+public:
+    class Seeker;
+    class Cursor;
+
+    PostingList() = default;
+    // Массивы должны жить, пока список на них ссылается. block_max_freqs -
+    // наибольшие частоты каждых IndexSegment::POSTING_BLOCK_SIZE вхождений.
+    PostingList(ArrayView<int> document_ids, ArrayView<double> term_freqs, ArrayView<double> block_max_freqs);
+
+    void Add(int document_id, double term_freq);
+    bool Remove(int document_id);
+    // удаляет вхождения document_ids (по возрастанию) за один проход
+    void RemoveSorted(const std::vector<int>& document_ids);
+    bool Contains(int document_id) const;
+    size_t Size() const;
+    bool Empty() const;
+    void Merge();
+    size_t GetMemoryBytes() const;
+    // не меньше частоты любого вхождения
+    double GetMaxTermFreq() const;
+
+    // обходит вхождения в порядке возрастания document_id
+    template <typename Func>
+    void ForEach(Func func) const;
+
+    // то же для document_id из [first, last)
+    template <typename Func>
+    void ForEachInRange(int first, int last, Func func) const;
+
+private:
+    static constexpr size_t MIN_PENDING_SIZE = 64;
+    // при большем числе удаляемых вхождений список пересобирается целиком
+    static constexpr size_t MAX_SINGLE_REMOVALS = 4;
+
+    size_t GetMainSize() const;
+    // заменяет все вхождения сжатыми блоками из ids и freqs
+    void Assign(const std::vector<int>& ids, const std::vector<double>& freqs);
+    // сжимает основную часть из внешней памяти в свои блоки
+    void Detach();
+
+    PostingBlocks blocks_;
+    ArrayView<int> external_ids_;
+    ArrayView<double> external_freqs_;
+    ArrayView<double> external_block_max_freqs_;
+    double external_max_freq_ = 0.0;
+    bool is_external_ = false;
+    std::vector<int> pending_ids_;
+    std::vector<double> pending_freqs_;
+    double pending_max_freq_ = 0.0;
+};
+
+// Проверяет, есть ли в списке документы возрастающей последовательности
+// id, за один проход по списку с галопирующим поиском: k проверок стоят
+// около O(k log(n / k)) вместо O(n) при обходе всего списка.
+class PostingList::Seeker {
+public:
+    explicit Seeker(const PostingList& postings);
+    // document_id не должны убывать от вызова к вызову
+    bool Contains(int document_id);
+
+private:
+    const PostingList& postings_;
+    PostingBlocks::Seeker blocks_;
+    size_t external_position_ = 0;
+    size_t pending_position_ = 0;
+};
+
+// Обход списка по возрастанию document_id с пропусками (см.
+// PostingBlocks::Cursor). Границы блока относятся к основной части,
+// вхождения буфера учитываются в наибольшей частоте блока целиком.
+class PostingList::Cursor {
+public:
+    static constexpr int END = PostingBlocks::Cursor::END;
+
+    // встаёт на первое вхождение не меньше first
+    Cursor(const PostingList& postings, int first);
+
+    // END, если вхождения кончились
+    int GetDocumentId() const {
+        return document_id_;
+    }
+    double GetTermFreq() const {
+        return term_freq_;
+    }
+
+    // document_id не должны убывать от вызова к вызову
+    void Advance(int document_id) {
+        if (document_id <= document_id_) {
+            return;
+        }
+        if (!postings_.is_external_ && postings_.pending_ids_.empty()) {
+            blocks_.Advance(document_id);
+            document_id_ = blocks_.GetId();
+            term_freq_ = blocks_.GetFreq();
+            return;
+        }
+        Seek(document_id);
+    }
+    // после него нужен Advance не меньше того же document_id
+    void ShallowAdvance(int document_id);
+    int GetBlockLastId() const;
+    double GetBlockMaxFreq() const;
+
+private:
+    void Seek(int document_id);
+
+    const PostingList& postings_;
+    PostingBlocks::Cursor blocks_;
+    size_t external_position_ = 0;
+    size_t pending_position_ = 0;
+    int document_id_ = std::numeric_limits<int>::min();
+    double term_freq_ = 0.0;
+};
+
+// Вхождения слова, разделённые на части по статусу документа: поиск
+// с фильтром по статусу обходит только часть своего статуса. Хранятся
+// только непустые части, каждый документ лежит ровно в одной из них.
+// Вхождения сохранённого сегмента читаются из файла общей неразделённой
+// частью; документ переходит из неё в часть своего статуса, когда
+// статус меняется (см. SearchServer::SetDocumentStatus).
+class StatusPostings {
+public:
+    class Seeker;
+
+    StatusPostings() = default;
+    // только неразделённая часть
+    explicit StatusPostings(PostingList unsplit);
+
+    void Add(int document_id, double term_freq, DocumentStatus status);
+    // ищет документ в части status, затем в неразделённой
+    bool Remove(int document_id, DocumentStatus status);
+    // удаляет вхождения document_ids (по возрастанию) из всех частей
+    void RemoveSorted(const std::vector<int>& document_ids);
+    // переносит вхождение документа в часть статуса to
+    void Move(int document_id, double term_freq, DocumentStatus from, DocumentStatus to);
+    bool Contains(int document_id, DocumentStatus status) const;
+    size_t Size() const;
+    bool Empty() const;
+    size_t GetMemoryBytes() const;
+
+    // func(const PostingList&) для частей, где могут быть документы
+    // со статусом status: его части и неразделённой; без status - для всех
+    template <typename Func>
+    void ForEachPart(std::optional<DocumentStatus> status, Func func) const;
+
+    // func(document_id, term_freq) по частям, в части по возрастанию document_id
+    template <typename Func>
+    void ForEach(Func func) const;
+
+private:
+    static constexpr uint8_t UNSPLIT = 0xFF;
+
+    struct Part {
+        uint8_t status;
+        PostingList postings;
+    };
+
+    static uint8_t GetKey(DocumentStatus status);
+    PostingList* FindPart(uint8_t key);
+    const PostingList* FindPart(uint8_t key) const;
+    PostingList& GetPartToAdd(uint8_t key);
+    void EraseEmptyParts();
+
+    std::vector<Part> parts_;
+};
+
+// Проверка документов по возрастанию id (см. PostingList::Seeker): каждая
+// часть проходится один раз. Id должны возрастать для каждого статуса.
+class StatusPostings::Seeker {
+public:
+    explicit Seeker(const StatusPostings& postings);
+    bool Contains(int document_id, DocumentStatus status);
+
+private:
+    const StatusPostings& postings_;
+    // по частям postings_
+    std::vector<PostingList::Seeker> seekers_;
+};
+
+// Словарь слов со списками вхождений.
+// Каждое слово хранится один раз в общей арене и получает числовой id,
+// по которому документы и списки вхождений ссылаются на него.
+// Слово без вхождений остаётся в словаре до уплотнения, которое
+// освобождает такие id и переносит живые слова в новую арену.
+// Таблицы копируются по сегментам только при изменении, так что копия
+// индекса разделяет с оригиналом все нетронутые данные.
+// Индекс может начинаться с сохранённого сегмента: его слова получают
+// id [0, число слов сегмента), списки читаются прямо из файла, а изменённые
+// списки и новые слова хранятся в памяти поверх сегмента.
+class InvertedIndex {
+public:
+    static constexpr uint32_t NO_TERM = std::numeric_limits<uint32_t>::max();
+
+    InvertedIndex() = default;
+    explicit InvertedIndex(std::shared_ptr<const IndexSegment> segment);
+
+    uint32_t FindTermId(std::string_view word) const;
+    std::string_view GetTerm(uint32_t term_id) const;
+
+    // список вхождений слова или nullptr, если вхождений нет
+    const StatusPostings* Find(std::string_view word) const;
+    const StatusPostings& GetPostings(uint32_t term_id) const;
+    // список вхождений, который можно менять, не затрагивая копии индекса
+    StatusPostings& GetMutablePostings(uint32_t term_id);
+
+    // добавляет вхождение и возвращает id слова
+    uint32_t Add(std::string_view word, int document_id, double term_freq, DocumentStatus status);
+    // id слова; новое слово добавляется в словарь без вхождений
+    uint32_t AddTerm(std::string_view word);
+    // Список для пакетного добавления вхождений: слово сразу перестаёт
+    // считаться пустым, поэтому в список нужно добавить хотя бы одно
+    // вхождение. Ссылка действительна до следующего изменения словаря
+    // или копирования индекса; разные списки можно заполнять параллельно.
+    StatusPostings& GetPostingsToAdd(uint32_t term_id);
+    void Remove(uint32_t term_id, int document_id, DocumentStatus status);
+    // учитывает слово, чей список опустел при изменении через GetMutablePostings
+    void OnPostingsEmptied(uint32_t term_id);
+
+    // func(term_id, term, postings) для каждого слова, у которого есть вхождения
+    template <typename Func>
+    void ForEachTerm(Func func) const;
+
+    // число слов, у которых есть вхождения
+    size_t TermCount() const;
+    // уплотнение выгодно, когда пустых слов много
+    bool NeedsCompaction() const;
+    // переносит живые слова в новую арену, старая остаётся у владельцев
+    void Compact();
+    std::shared_ptr<const TermArena> GetArena() const;
+
+private:
+    static constexpr size_t MIN_COMPACTION_TERMS = 1024;
+
+    bool IsSegmentTerm(uint32_t term_id) const;
+    const StatusPostings& GetSegmentPostings(uint32_t term_id) const;
+
+    std::shared_ptr<const IndexSegment> segment_;
+    uint32_t segment_term_count_ = 0;
+    // списки слов сегмента, изменённые после открытия
+    CowHashMap<uint32_t, CowPtr<StatusPostings>> segment_postings_;
+    // неизменённые списки слов сегмента поверх данных файла
+    LazyMap<uint32_t, StatusPostings> segment_views_;
+
+    // слова, добавленные в память; id слова - segment_term_count_ + индекс
+    std::shared_ptr<TermArena> arena_ = std::make_shared<TermArena>();
+    CowHashMap<std::string_view, uint32_t> term_ids_;
+    CowVector<std::string_view> terms_;
+    CowVector<CowPtr<StatusPostings>> postings_;
+    CowVector<uint32_t> free_term_ids_;
+    size_t empty_term_count_ = 0;
+    // пустые слова сегмента не освобождаются уплотнением
+    size_t empty_segment_term_count_ = 0;
+};
+
+template <typename Func>
+void PostingList::ForEach(Func func) const {
+    // вхождения буфера вставляются между вхождениями основной части
+    size_t j = 0;
+    auto main_func = [&](int document_id, double term_freq) {
+        for (; j < pending_ids_.size() && pending_ids_[j] < document_id; ++j) {
+            func(pending_ids_[j], pending_freqs_[j]);
+        }
+        func(document_id, term_freq);
+    };
+    if (is_external_) {
+        for (size_t i = 0; i < external_ids_.size(); ++i) {
+            main_func(external_ids_[i], external_freqs_[i]);
+        }
+    }
+    else {
+        blocks_.ForEach(main_func);
+    }
+    for (; j < pending_ids_.size(); ++j) {
+        func(pending_ids_[j], pending_freqs_[j]);
+    }
+}
+
+template <typename Func>
+void PostingList::ForEachInRange(int first, int last, Func func) const {
+    size_t j = std::lower_bound(pending_ids_.begin(), pending_ids_.end(), first) - pending_ids_.begin();
+    const size_t j_end = std::lower_bound(pending_ids_.begin() + j, pending_ids_.end(), last) - pending_ids_.begin();
+    auto main_func = [&](int document_id, double term_freq) {
+        for (; j < j_end && pending_ids_[j] < document_id; ++j) {
+            func(pending_ids_[j], pending_freqs_[j]);
+        }
+        func(document_id, term_freq);
+    };
+    if (is_external_) {
+        const int* ids = external_ids_.begin();
+        size_t i = std::lower_bound(ids, external_ids_.end(), first) - ids;
+        for (; i < external_ids_.size() && ids[i] < last; ++i) {
+            main_func(ids[i], external_freqs_[i]);
+        }
+    }
+    else {
+        blocks_.ForEachInRange(first, last, main_func);
+    }
+    for (; j < j_end; ++j) {
+        func(pending_ids_[j], pending_freqs_[j]);
+    }
+}
+
+template <typename Func>
+void StatusPostings::ForEachPart(std::optional<DocumentStatus> status, Func func) const {
+    for (const Part& part : parts_) {
+        if (!status || part.status == GetKey(*status) || part.status == UNSPLIT) {
+            func(part.postings);
+        }
+    }
+}
+
+template <typename Func>
+void StatusPostings::ForEach(Func func) const {
+    for (const Part& part : parts_) {
+        part.postings.ForEach(func);
+    }
+}
+
+template <typename Func>
+void InvertedIndex::ForEachTerm(Func func) const {
+    for (uint32_t term_id = 0; term_id < segment_term_count_; ++term_id) {
+        const StatusPostings& postings = GetPostings(term_id);
+        if (!postings.Empty()) {
+            func(term_id, segment_->GetTerm(term_id), postings);
+        }
+    }
+    for (uint32_t index = 0; index < terms_.size(); ++index) {
+        if (terms_[index].data() != nullptr && !postings_[index]->Empty()) {
+            func(segment_term_count_ + index, terms_[index], *postings_[index]);
+        }
+    }
+}
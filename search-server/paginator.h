@@ -1,5 +1,11 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
 template <typename Iterator>
 struct IteratorRange {
@@ -8,45 +14,111 @@ struct IteratorRange {
     IteratorRange(Iterator begin, Iterator end) :begin(begin), end(end) {}
 };
 
+// Страницы диапазона по page_size элементов. Страницы не хранятся,
+// а строятся при обходе: элементы не копируются, память не выделяется,
+// подходят любые однонаправленные итераторы. Для итераторов
+// произвольного доступа граница страницы находится за O(1).
 template <typename Iterator>
 class Paginator {
 public:
+    class PageIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IteratorRange<Iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
 
-    Paginator(Iterator begin, Iterator end, int size)
-        :page_size_(size) {
-        vector test(begin, end);
-        Iterator temp = begin;
-        for (; temp + size < end; temp += size) {
-            pages_.push_back(IteratorRange(temp, temp + size));
+        PageIterator(Iterator page_begin, Iterator end, size_t page_size)
+            : page_(page_begin, page_begin)
+            , end_(end)
+            , page_size_(page_size) {
+            page_.end = Advance(page_.begin);
         }
-        if (temp < end) {
-            pages_.push_back(IteratorRange(temp, end));
+
+        reference operator*() const {
+            return page_;
+        }
+
+        pointer operator->() const {
+            return &page_;
+        }
+
+        PageIterator& operator++() {
+            page_.begin = page_.end;
+            page_.end = Advance(page_.begin);
+            return *this;
+        }
+
+        PageIterator operator++(int) {
+            PageIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            return page_.begin == other.page_.begin;
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        // не дальше page_size_ элементов от first и не дальше конца
+        Iterator Advance(Iterator first) const {
+            using Category = typename std::iterator_traits<Iterator>::iterator_category;
+            if constexpr (std::is_base_of_v<std::random_access_iterator_tag, Category>) {
+                const auto rest = static_cast<size_t>(end_ - first);
+                return first + static_cast<typename std::iterator_traits<Iterator>::difference_type>(std::min(rest, page_size_));
+            }
+            else {
+                for (size_t i = 0; i < page_size_ && first != end_; ++i) {
+                    ++first;
+                }
+                return first;
+            }
+        }
+
+        IteratorRange<Iterator> page_;
+        Iterator end_;
+        size_t page_size_;
+    };
+
+    Paginator(Iterator begin, Iterator end, size_t size)
+        : begin_(begin)
+        , end_(end)
+        , page_size_(size) {
+        if (size == 0) {
+            throw std::invalid_argument(std::string("Page size must be positive"));
         }
     }
 
-    auto begin() const {
-        return pages_.begin();
+    PageIterator begin() const {
+        return { begin_, end_, page_size_ };
     }
-    auto end() const {
-        return pages_.end();
+    PageIterator end() const {
+        return { end_, end_, page_size_ };
     }
-    int size() const {
+    // размер страницы
+    size_t size() const {
         return page_size_;
     }
 
 private:
-    int page_size_;
-    vector<IteratorRange<Iterator>> pages_;
+    Iterator begin_;
+    Iterator end_;
+    size_t page_size_;
 };
 
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
-    return Paginator(begin(c), end(c), page_size);
+    return Paginator(std::begin(c), std::end(c), page_size);
 }
 
 template<typename Iterator>
-ostream& operator<< (ostream& out, IteratorRange<Iterator> p) {
-    for (auto i = p.begin; i < p.end; i++) {
+std::ostream& operator<< (std::ostream& out, IteratorRange<Iterator> p) {
+    for (auto i = p.begin; i != p.end; ++i) {
         out << *i;
     }
     return out;
@@ -0,0 +1,430 @@
+#include "posting_blocks.h"
+#include <algorithm>
+#include <cstring>
+// POSTING_BLOCKS_NO_SIMD отключает векторное раскодирование при сборке
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(POSTING_BLOCKS_NO_SIMD)
+#define POSTING_BLOCKS_SSSE3
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const uint8_t RAW_FREQS = 0;
+const uint8_t DICTIONARY_FREQS = 1;
+
+// StreamVByte: на каждые 4 числа байт управления по 2 бита на длину числа,
+// затем сами числа по 1-4 младших байта
+void EncodeDeltas(const int* ids, size_t count, std::vector<uint8_t>& out) {
+    const size_t delta_count = count - 1;
+    const size_t control = out.size();
+    out.resize(out.size() + (delta_count + 3) / 4, 0);
+    for (size_t i = 0; i < delta_count; ++i) {
+        const uint32_t delta = static_cast<uint32_t>(ids[i + 1]) - static_cast<uint32_t>(ids[i]);
+        const uint32_t length = delta < (1u << 8) ? 1 : delta < (1u << 16) ? 2 : delta < (1u << 24) ? 3 : 4;
+        out[control + i / 4] |= static_cast<uint8_t>((length - 1) << (i % 4 * 2));
+        for (uint32_t byte = 0; byte < length; ++byte) {
+            out.push_back(static_cast<uint8_t>(delta >> (8 * byte)));
+        }
+    }
+}
+
+// раскодирует разности с номера first и возвращает конец данных
+const uint8_t* DecodeDeltasFrom(const uint8_t* control, const uint8_t* data, size_t first, size_t delta_count,
+    uint32_t previous, int* out) {
+    for (size_t i = first; i < delta_count; ++i) {
+        const uint32_t length = ((control[i / 4] >> (i % 4 * 2)) & 3) + 1;
+        uint32_t delta = 0;
+        for (uint32_t byte = 0; byte < length; ++byte) {
+            delta |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+        }
+        data += length;
+        previous += delta;
+        out[i] = static_cast<int>(previous);
+    }
+    return data;
+}
+
+const uint8_t* DecodeDeltasScalar(const uint8_t* in, const uint8_t* /*in_end*/, size_t delta_count, int previous, int* out) {
+    return DecodeDeltasFrom(in, in + (delta_count + 3) / 4, 0, delta_count, static_cast<uint32_t>(previous), out);
+}
+
+#ifdef POSTING_BLOCKS_SSSE3
+// для каждого байта управления: маска pshufb, раскладывающая 4 числа
+// по 32-битным ячейкам, и число занятых ими байт
+struct ShuffleTables {
+    alignas(16) uint8_t masks[256][16];
+    uint8_t lengths[256];
+
+    ShuffleTables() {
+        for (int control = 0; control < 256; ++control) {
+            uint8_t source = 0;
+            for (int lane = 0; lane < 4; ++lane) {
+                const int length = ((control >> (lane * 2)) & 3) + 1;
+                for (int byte = 0; byte < 4; ++byte) {
+                    masks[control][lane * 4 + byte] = byte < length ? source++ : 0x80;
+                }
+            }
+            lengths[control] = source;
+        }
+    }
+};
+
+__attribute__((target("ssse3")))
+const uint8_t* DecodeDeltasSsse3(const uint8_t* in, const uint8_t* in_end, size_t delta_count, int previous, int* out) {
+    static const ShuffleTables tables;
+    const uint8_t* control = in;
+    const uint8_t* data = in + (delta_count + 3) / 4;
+    __m128i last = _mm_set1_epi32(previous);
+    size_t i = 0;
+    // загрузка читает 16 байт, поэтому у конца буфера доделывает скалярный код
+    for (; i + 4 <= delta_count && data + 16 <= in_end; i += 4) {
+        const uint8_t group = control[i / 4];
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        values = _mm_shuffle_epi8(values, _mm_load_si128(reinterpret_cast<const __m128i*>(tables.masks[group])));
+        data += tables.lengths[group];
+        // префиксные суммы разностей внутри четвёрки
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        values = _mm_add_epi32(values, last);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), values);
+        last = _mm_shuffle_epi32(values, 0xFF);
+    }
+    const uint32_t previous_id = static_cast<uint32_t>(i == 0 ? previous : out[i - 1]);
+    return DecodeDeltasFrom(control, data, i, delta_count, previous_id, out);
+}
+#endif
+
+using DecodeDeltasFunction = const uint8_t* (*)(const uint8_t*, const uint8_t*, size_t, int, int*);
+
+struct DeltaDecoder {
+    DecodeDeltasFunction function;
+    const char* name;
+};
+
+const DeltaDecoder& GetDeltaDecoder() {
+    static const DeltaDecoder decoder = []() -> DeltaDecoder {
+#ifdef POSTING_BLOCKS_SSSE3
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("ssse3")) {
+            return { DecodeDeltasSsse3, "ssse3" };
+        }
+#endif
+        return { DecodeDeltasScalar, "scalar" };
+    }();
+    return decoder;
+}
+
+// Частоты блока обычно принимают немного значений (1/n, 2/n, ...),
+// поэтому словарь с однобайтовыми номерами почти всегда короче
+void EncodeFreqs(const double* freqs, size_t count, std::vector<uint8_t>& out) {
+    std::vector<double> values(freqs, freqs + count);
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    if (2 + values.size() * sizeof(double) + count < 1 + count * sizeof(double)) {
+        out.push_back(DICTIONARY_FREQS);
+        out.push_back(static_cast<uint8_t>(values.size() - 1));
+        const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        out.insert(out.end(), bytes, bytes + values.size() * sizeof(double));
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(static_cast<uint8_t>(std::lower_bound(values.begin(), values.end(), freqs[i]) - values.begin()));
+        }
+    }
+    else {
+        out.push_back(RAW_FREQS);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(freqs);
+        out.insert(out.end(), bytes, bytes + count * sizeof(double));
+    }
+}
+
+void DecodeFreqs(const uint8_t* in, size_t count, double* out) {
+    if (in[0] == DICTIONARY_FREQS) {
+        const size_t value_count = static_cast<size_t>(in[1]) + 1;
+        double values[PostingBlocks::BLOCK_SIZE];
+        std::memcpy(values, in + 2, value_count * sizeof(double));
+        const uint8_t* indexes = in + 2 + value_count * sizeof(double);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = values[indexes[i]];
+        }
+    }
+    else {
+        std::memcpy(out, in + 1, count * sizeof(double));
+    }
+}
+
+} // namespace
+
+const char* GetPostingDecoderName() {
+    return GetDeltaDecoder().name;
+}
+
+void PostingBlocks::Assign(const int* ids, const double* freqs, size_t size) {
+    groups_.clear();
+    block_count_ = 0;
+    tail_ids_.clear();
+    tail_freqs_.clear();
+    max_freq_ = 0.0;
+    size_t i = 0;
+    for (; i + BLOCK_SIZE <= size; i += BLOCK_SIZE) {
+        AppendBlock(ids + i, freqs + i, BLOCK_SIZE);
+    }
+    tail_ids_.assign(ids + i, ids + size);
+    tail_freqs_.assign(freqs + i, freqs + size);
+    tail_max_freq_ = tail_freqs_.empty() ? 0.0 : *std::max_element(tail_freqs_.begin(), tail_freqs_.end());
+    max_freq_ = std::max(max_freq_, tail_max_freq_);
+    size_ = size;
+}
+
+void PostingBlocks::Append(int id, double freq) {
+    tail_ids_.push_back(id);
+    tail_freqs_.push_back(freq);
+    tail_max_freq_ = std::max(tail_max_freq_, freq);
+    max_freq_ = std::max(max_freq_, freq);
+    ++size_;
+    if (tail_ids_.size() == BLOCK_SIZE) {
+        AppendBlock(tail_ids_.data(), tail_freqs_.data(), BLOCK_SIZE);
+        tail_ids_.clear();
+        tail_freqs_.clear();
+        tail_max_freq_ = 0.0;
+    }
+}
+
+bool PostingBlocks::Remove(int id) {
+    const size_t block_index = FindBlock(id);
+    if (block_index == block_count_) {
+        const auto it = std::lower_bound(tail_ids_.begin(), tail_ids_.end(), id);
+        if (it == tail_ids_.end() || *it != id) {
+            return false;
+        }
+        tail_freqs_.erase(tail_freqs_.begin() + (it - tail_ids_.begin()));
+        tail_ids_.erase(it);
+        --size_;
+        return true;
+    }
+
+    int ids[BLOCK_SIZE];
+    double freqs[BLOCK_SIZE];
+    DecodeBlock(block_index, ids, freqs);
+    const size_t count = GetBlock(block_index).count;
+    const auto it = std::lower_bound(ids, ids + count, id);
+    if (it == ids + count || *it != id) {
+        return false;
+    }
+    if (count == 1) {
+        // номера блоков сдвигаются во всех следующих группах, поэтому
+        // список пересобирается; так бывает только после удаления
+        // всех вхождений блока по одному
+        std::vector<int> all_ids;
+        std::vector<double> all_freqs;
+        all_ids.reserve(size_);
+        all_freqs.reserve(size_);
+        auto collect = [&](int document_id, double freq) {
+            if (document_id != id) {
+                all_ids.push_back(document_id);
+                all_freqs.push_back(freq);
+            }
+        };
+        ForEach(collect);
+        Assign(all_ids.data(), all_freqs.data(), all_ids.size());
+        return true;
+    }
+    const size_t pos = it - ids;
+    std::copy(ids + pos + 1, ids + count, ids + pos);
+    std::copy(freqs + pos + 1, freqs + count, freqs + pos);
+    --size_;
+
+    // блок перекодируется на месте, следующие блоки группы сдвигаются
+    Group& group = GetMutableGroup(block_index / GROUP_SIZE);
+    const size_t index = block_index % GROUP_SIZE;
+    Block& block = group.blocks[index];
+    const size_t begin = block.offset;
+    const size_t end = index + 1 < group.blocks.size() ? group.blocks[index + 1].offset : group.data.size();
+    std::vector<uint8_t> encoded;
+    EncodeDeltas(ids, count - 1, encoded);
+    EncodeFreqs(freqs, count - 1, encoded);
+    group.data.erase(group.data.begin() + begin, group.data.begin() + end);
+    group.data.insert(group.data.begin() + begin, encoded.begin(), encoded.end());
+    for (size_t i = index + 1; i < group.blocks.size(); ++i) {
+        group.blocks[i].offset = static_cast<uint32_t>(group.blocks[i].offset + encoded.size() - (end - begin));
+    }
+    block.count = static_cast<uint32_t>(count - 1);
+    block.first_id = ids[0];
+    block.last_id = ids[block.count - 1];
+    block.max_freq = *std::max_element(freqs, freqs + block.count);
+    return true;
+}
+
+bool PostingBlocks::Contains(int id) const {
+    const size_t block_index = FindBlock(id);
+    if (block_index == block_count_) {
+        return std::binary_search(tail_ids_.begin(), tail_ids_.end(), id);
+    }
+    const Block& block = GetBlock(block_index);
+    if (block.first_id > id) {
+        return false;
+    }
+    int ids[BLOCK_SIZE];
+    DecodeIds(block_index, ids);
+    return std::binary_search(ids, ids + block.count, id);
+}
+
+size_t PostingBlocks::Size() const {
+    return size_;
+}
+
+bool PostingBlocks::Empty() const {
+    return size_ == 0;
+}
+
+int PostingBlocks::GetLastId() const {
+    return tail_ids_.empty() ? GetBlock(block_count_ - 1).last_id : tail_ids_.back();
+}
+
+double PostingBlocks::GetMaxFreq() const {
+    return max_freq_;
+}
+
+size_t PostingBlocks::GetMemoryBytes() const {
+    size_t bytes = groups_.capacity() * sizeof(std::shared_ptr<Group>)
+        + tail_ids_.capacity() * sizeof(int) + tail_freqs_.capacity() * sizeof(double);
+    for (const auto& group : groups_) {
+        bytes += sizeof(Group) + group->blocks.capacity() * sizeof(Block) + group->data.capacity();
+    }
+    return bytes;
+}
+
+PostingBlocks::Group& PostingBlocks::GetMutableGroup(size_t group_index) {
+    auto& group = groups_[group_index];
+    if (group.use_count() > 1) {
+        group = std::make_shared<Group>(*group);
+    }
+    return *group;
+}
+
+void PostingBlocks::AppendBlock(const int* ids, const double* freqs, size_t count) {
+    if (block_count_ % GROUP_SIZE == 0) {
+        groups_.push_back(std::make_shared<Group>());
+        groups_.back()->blocks.reserve(GROUP_SIZE);
+    }
+    Group& group = GetMutableGroup(groups_.size() - 1);
+    const double max_freq = *std::max_element(freqs, freqs + count);
+    group.blocks.push_back({ ids[0], ids[count - 1], static_cast<uint32_t>(group.data.size()), static_cast<uint32_t>(count), max_freq });
+    max_freq_ = std::max(max_freq_, max_freq);
+    EncodeDeltas(ids, count, group.data);
+    EncodeFreqs(freqs, count, group.data);
+    ++block_count_;
+}
+
+void PostingBlocks::DecodeIds(size_t block_index, int* ids) const {
+    const Group& group = *groups_[block_index / GROUP_SIZE];
+    const Block& block = group.blocks[block_index % GROUP_SIZE];
+    ids[0] = block.first_id;
+    GetDeltaDecoder().function(group.data.data() + block.offset, group.data.data() + group.data.size(),
+        block.count - 1, block.first_id, ids + 1);
+}
+
+void PostingBlocks::DecodeBlock(size_t block_index, int* ids, double* freqs) const {
+    const Group& group = *groups_[block_index / GROUP_SIZE];
+    const Block& block = group.blocks[block_index % GROUP_SIZE];
+    ids[0] = block.first_id;
+    const uint8_t* freqs_data = GetDeltaDecoder().function(group.data.data() + block.offset,
+        group.data.data() + group.data.size(), block.count - 1, block.first_id, ids + 1);
+    DecodeFreqs(freqs_data, block.count, freqs);
+}
+
+PostingBlocks::Seeker::Seeker(const PostingBlocks& blocks)
+    : blocks_(blocks) {
+}
+
+bool PostingBlocks::Seeker::Contains(int id) {
+    block_index_ = blocks_.FindBlock(id, block_index_);
+    if (block_index_ == blocks_.block_count_) {
+        const auto& tail = blocks_.tail_ids_;
+        tail_position_ = GallopLowerBound(tail.begin() + tail_position_, tail.end(), id) - tail.begin();
+        return tail_position_ < tail.size() && tail[tail_position_] == id;
+    }
+    const Block& block = blocks_.GetBlock(block_index_);
+    if (block.first_id > id) {
+        return false;
+    }
+    if (decoded_block_ != block_index_) {
+        blocks_.DecodeIds(block_index_, ids_);
+        decoded_block_ = block_index_;
+        position_ = 0;
+    }
+    // последний id блока не меньше id, поэтому позиция внутри блока
+    position_ = GallopLowerBound(ids_ + position_, ids_ + block.count, id) - ids_;
+    return ids_[position_] == id;
+}
+
+PostingBlocks::Cursor::Cursor(const PostingBlocks& blocks)
+    : blocks_(blocks) {
+}
+
+void PostingBlocks::Cursor::Seek(int id) {
+    ShallowAdvance(id);
+    if (block_index_ == blocks_.block_count_) {
+        const auto& tail = blocks_.tail_ids_;
+        position_ = GallopLowerBound(tail.begin() + position_, tail.end(), id) - tail.begin();
+        if (position_ == tail.size()) {
+            id_ = END;
+            freq_ = 0.0;
+        }
+        else {
+            id_ = tail[position_];
+            freq_ = blocks_.tail_freqs_[position_];
+        }
+        return;
+    }
+    if (decoded_block_ != block_index_) {
+        blocks_.DecodeBlock(block_index_, ids_, freqs_);
+        decoded_block_ = block_index_;
+        decoded_count_ = blocks_.GetBlock(block_index_).count;
+    }
+    // последний id блока не меньше id, поэтому позиция внутри блока
+    position_ = GallopLowerBound(ids_ + position_, ids_ + decoded_count_, id) - ids_;
+    id_ = ids_[position_];
+    freq_ = freqs_[position_];
+}
+
+void PostingBlocks::Cursor::ShallowAdvance(int id) {
+    const size_t block_index = blocks_.FindBlock(id, block_index_);
+    if (block_index != block_index_) {
+        block_index_ = block_index;
+        position_ = 0;
+    }
+}
+
+int PostingBlocks::Cursor::GetBlockLastId() const {
+    return block_index_ < blocks_.block_count_ ? blocks_.GetBlock(block_index_).last_id : END;
+}
+
+double PostingBlocks::Cursor::GetBlockMaxFreq() const {
+    return block_index_ < blocks_.block_count_ ? blocks_.GetBlock(block_index_).max_freq : blocks_.tail_max_freq_;
+}
+
+size_t PostingBlocks::FindBlock(int first, size_t from) const {
+    const auto is_before = [this, first](size_t block_index) {
+        return GetBlock(block_index).last_id < first;
+    };
+    if (from == block_count_ || !is_before(from)) {
+        return from;
+    }
+    size_t bound = 1;
+    while (from + bound < block_count_ && is_before(from + bound)) {
+        bound *= 2;
+    }
+    // ответ в (from + bound / 2, from + bound]
+    size_t low = from + bound / 2 + 1;
+    size_t high = std::min(from + bound, block_count_);
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if (is_before(middle)) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
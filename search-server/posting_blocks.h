@@ -0,0 +1,210 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Первый элемент [first, last), не меньший value. Граница ищется шагами
+// 1, 2, 4, ... от first, поэтому поиск близкого ответа почти ничего
+// не стоит, а далёкого - O(log расстояния).
+template <typename Iterator, typename T, typename Less = std::less<>>
+Iterator GallopLowerBound(Iterator first, Iterator last, const T& value, Less less = {}) {
+    if (first == last || !less(*first, value)) {
+        return first;
+    }
+    const size_t size = last - first;
+    size_t bound = 1;
+    while (bound < size && less(first[bound], value)) {
+        bound *= 2;
+    }
+    return std::lower_bound(first + bound / 2 + 1, first + std::min(bound + 1, size), value, less);
+}
+
+// Сжатая основная часть списка вхождений.
+// Вхождения по возрастанию id делятся на блоки по BLOCK_SIZE: id блока
+// хранятся разностями соседних id в формате StreamVByte (от 1 до 4 байт
+// на число), частоты - словарём различных значений блока и однобайтовыми
+// номерами, если так короче, иначе как есть. Частоты не округляются.
+// Последние вхождения копятся несжатыми, пока не наберётся целый блок.
+// Блоки раскодируются по одному при обходе, весь список не разворачивается.
+// Таблица блоков с первым и последним id служит указателями пропуска,
+// в ней же хранится наибольшая частота блока для отсечения при поиске.
+// Блоки хранятся группами по GROUP_SIZE с копированием группы при записи:
+// копия списка разделяет с оригиналом все группы, а запись в копию
+// копирует только изменяемую группу и несжатый хвост.
+class PostingBlocks {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+    static constexpr size_t GROUP_SIZE = 64;
+
+    // Проверяет принадлежность возрастающей последовательности id за один
+    // проход: блоки пропускаются по таблице, внутри блока поиск продолжается
+    // с места предыдущего ответа.
+    class Seeker {
+    public:
+        explicit Seeker(const PostingBlocks& blocks);
+        bool Contains(int id);
+
+    private:
+        static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+
+        const PostingBlocks& blocks_;
+        size_t block_index_ = 0;
+        size_t decoded_block_ = NO_BLOCK;
+        size_t position_ = 0;
+        size_t tail_position_ = 0;
+        int ids_[BLOCK_SIZE];
+    };
+
+    // Обход по возрастанию id с пропусками. Advance переходит к первому
+    // id не меньше заданного и раскодирует только блок, в котором тот
+    // лежит. ShallowAdvance только выбирает такой блок, чтобы узнать
+    // его границы и наибольшую частоту без раскодирования; после него
+    // id и частота не определены до следующего Advance не меньше того же id.
+    class Cursor {
+    public:
+        static constexpr int END = std::numeric_limits<int>::max();
+
+        explicit Cursor(const PostingBlocks& blocks);
+
+        // END, если id кончились
+        int GetId() const {
+            return id_;
+        }
+        double GetFreq() const {
+            return freq_;
+        }
+
+        // id не должны убывать от вызова к вызову
+        void Advance(int id) {
+            if (id <= id_) {
+                return;
+            }
+            // чаще всего следующий id лежит в уже раскодированном блоке
+            if (decoded_block_ == block_index_ && id <= ids_[decoded_count_ - 1]) {
+                position_ = GallopLowerBound(ids_ + position_, ids_ + decoded_count_, id) - ids_;
+                id_ = ids_[position_];
+                freq_ = freqs_[position_];
+                return;
+            }
+            Seek(id);
+        }
+        void ShallowAdvance(int id);
+        // последний id и наибольшая частота выбранного блока;
+        // несжатый хвост считается блоком до END
+        int GetBlockLastId() const;
+        double GetBlockMaxFreq() const;
+
+    private:
+        static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+
+        void Seek(int id);
+
+        const PostingBlocks& blocks_;
+        size_t block_index_ = 0;
+        size_t decoded_block_ = NO_BLOCK;
+        size_t decoded_count_ = 0;
+        size_t position_ = 0;
+        int id_ = std::numeric_limits<int>::min();
+        double freq_ = 0.0;
+        int ids_[BLOCK_SIZE];
+        double freqs_[BLOCK_SIZE];
+    };
+
+    // ids должны возрастать
+    void Assign(const int* ids, const double* freqs, size_t size);
+    // id должен быть больше всех имеющихся
+    void Append(int id, double freq);
+    bool Remove(int id);
+    bool Contains(int id) const;
+
+    size_t Size() const;
+    bool Empty() const;
+    int GetLastId() const;
+    // не меньше наибольшей частоты; после удалений может быть завышена
+    double GetMaxFreq() const;
+    size_t GetMemoryBytes() const;
+
+    // func(id, freq) по возрастанию id
+    template <typename Func>
+    void ForEach(Func& func) const;
+
+    // то же для id из [first, last)
+    template <typename Func>
+    void ForEachInRange(int first, int last, Func& func) const;
+
+private:
+    struct Block {
+        int first_id;
+        int last_id;
+        // смещение в данных группы
+        uint32_t offset;
+        uint32_t count;
+        double max_freq;
+    };
+
+    // GROUP_SIZE блоков подряд, в последней группе - не больше
+    struct Group {
+        std::vector<Block> blocks;
+        std::vector<uint8_t> data;
+    };
+
+    const Block& GetBlock(size_t block_index) const {
+        return groups_[block_index / GROUP_SIZE]->blocks[block_index % GROUP_SIZE];
+    }
+    // группа, которую можно менять, не затрагивая копии списка
+    Group& GetMutableGroup(size_t group_index);
+    void AppendBlock(const int* ids, const double* freqs, size_t count);
+    void DecodeIds(size_t block_index, int* ids) const;
+    void DecodeBlock(size_t block_index, int* ids, double* freqs) const;
+    // первый блок не раньше from, в котором могут быть id >= first;
+    // граница ищется шагами 1, 2, 4, ... от from
+    size_t FindBlock(int first, size_t from = 0) const;
+
+    std::vector<std::shared_ptr<Group>> groups_;
+    size_t block_count_ = 0;
+    std::vector<int> tail_ids_;
+    std::vector<double> tail_freqs_;
+    double tail_max_freq_ = 0.0;
+    double max_freq_ = 0.0;
+    size_t size_ = 0;
+};
+
+// название реализации, выбранной для раскодирования id при запуске
+const char* GetPostingDecoderName();
+
+template <typename Func>
+void PostingBlocks::ForEach(Func& func) const {
+    int ids[BLOCK_SIZE];
+    double freqs[BLOCK_SIZE];
+    for (size_t block_index = 0; block_index < block_count_; ++block_index) {
+        DecodeBlock(block_index, ids, freqs);
+        for (size_t i = 0; i < GetBlock(block_index).count; ++i) {
+            func(ids[i], freqs[i]);
+        }
+    }
+    for (size_t i = 0; i < tail_ids_.size(); ++i) {
+        func(tail_ids_[i], tail_freqs_[i]);
+    }
+}
+
+template <typename Func>
+void PostingBlocks::ForEachInRange(int first, int last, Func& func) const {
+    int ids[BLOCK_SIZE];
+    double freqs[BLOCK_SIZE];
+    for (size_t block_index = FindBlock(first);
+        block_index < block_count_ && GetBlock(block_index).first_id < last; ++block_index) {
+        DecodeBlock(block_index, ids, freqs);
+        const size_t count = GetBlock(block_index).count;
+        size_t i = std::lower_bound(ids, ids + count, first) - ids;
+        for (; i < count && ids[i] < last; ++i) {
+            func(ids[i], freqs[i]);
+        }
+    }
+    size_t i = std::lower_bound(tail_ids_.begin(), tail_ids_.end(), first) - tail_ids_.begin();
+    for (; i < tail_ids_.size() && tail_ids_[i] < last; ++i) {
+        func(tail_ids_[i], tail_freqs_[i]);
+    }
+}
@@ -0,0 +1,40 @@
+#include "process_queries.h"
+
+namespace {
+    const StatusFilter IsActual{ DocumentStatus::ACTUAL };
+}
+
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    std::vector<std::vector<Document>> result(queries.size());
+    search_server.FindTopDocumentsBatch(queries, IsActual,
+        [&result](size_t query_index, const std::vector<Document>& documents) {
+            result[query_index] = documents;
+        });
+    return result;
+}
+
+std::vector<Document> ProcessQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    // у каждого запроса свой участок из MAX_RESULT_DOCUMENT_COUNT ячеек,
+    // после поиска участки сдвигаются вплотную друг к другу
+    const size_t slot_count = MAX_RESULT_DOCUMENT_COUNT;
+    std::vector<Document> result(queries.size() * slot_count);
+    std::vector<size_t> counts(queries.size());
+    search_server.FindTopDocumentsBatch(queries, IsActual,
+        [&result, &counts, slot_count](size_t query_index, const std::vector<Document>& documents) {
+            std::copy(documents.begin(), documents.end(), result.begin() + query_index * slot_count);
+            counts[query_index] = documents.size();
+        }, slot_count);
+
+    size_t size = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto first = result.begin() + i * slot_count;
+        std::move(first, first + counts[i], result.begin() + size);
+        size += counts[i];
+    }
+    result.resize(size);
+    return result;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "document.h"
+#include "search_server.h"
+
+// результаты поиска по каждому запросу пакета, статус ACTUAL
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// те же результаты одним плоским вектором в порядке запросов
+std::vector<Document> ProcessQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
@@ -0,0 +1,97 @@
+#include "query_cache.h"
+#include <functional>
+
+QueryCache::QueryCache(SearchServer& search_server, size_t capacity)
+    : search_server_(search_server)
+    , shard_capacity_((capacity + SHARD_COUNT - 1) / SHARD_COUNT) {
+}
+
+vector<Document> QueryCache::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_count) const {
+    const SearchServer::Query query = search_server_.NormalizeQuery(raw_query);
+    const string key = MakeKey(query, status, max_count);
+    const uint64_t index_epoch = search_server_.GetIndexEpoch();
+
+    Shard& shard = shards_[std::hash<string>{}(key) % SHARD_COUNT];
+    {
+        std::lock_guard guard(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            const auto entry = it->second;
+            if (entry->index_epoch == index_epoch) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+                ++hit_count_;
+                return entry->documents;
+            }
+            shard.index.erase(it);
+            shard.entries.erase(entry);
+        }
+    }
+
+    ++miss_count_;
+    vector<Document> documents = search_server_.FindTopDocuments(raw_query, status, max_count);
+
+    std::lock_guard guard(shard.mutex);
+    // запись мог успеть добавить другой поток
+    if (shard.index.count(key) == 0 && shard_capacity_ > 0) {
+        shard.entries.push_front({ key, index_epoch, documents });
+        shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+        if (shard.entries.size() > shard_capacity_) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+    }
+    return documents;
+}
+
+void QueryCache::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    search_server_.AddDocument(document_id, document, status, ratings);
+    Clear();
+}
+
+void QueryCache::RemoveDocument(int document_id) {
+    if (!search_server_.HasDocument(document_id)) {
+        return;
+    }
+    search_server_.RemoveDocument(document_id);
+    Clear();
+}
+
+void QueryCache::SetDocumentStatus(int document_id, DocumentStatus status) {
+    search_server_.SetDocumentStatus(document_id, status);
+    Clear();
+}
+
+void QueryCache::SetRankingModel(RankingModel model, const Bm25Params& params) {
+    search_server_.SetRankingModel(model, params);
+    Clear();
+}
+
+void QueryCache::Clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+    }
+}
+
+uint64_t QueryCache::GetHitCount() const {
+    return hit_count_;
+}
+
+uint64_t QueryCache::GetMissCount() const {
+    return miss_count_;
+}
+
+string QueryCache::MakeKey(const SearchServer::Query& query, DocumentStatus status, size_t max_count) {
+    // слова не содержат пробелов, поэтому ключ однозначен
+    string key = to_string(static_cast<int>(status)) + ' ' + to_string(max_count);
+    for (const string_view word : query.plus_words) {
+        key += ' ';
+        key += word;
+    }
+    for (const string_view word : query.minus_words) {
+        key += " -"s;
+        key += word;
+    }
+    return key;
+}
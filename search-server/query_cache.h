@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "search_server.h"
+
+// Кеш результатов FindTopDocuments по статусу для повторяющихся запросов.
+// Ключ - нормализованный запрос (плюс- и минус-слова без стоп-слов,
+// отсортированные и без повторов), статус и число документов в выдаче.
+// Кеш разбит на части со своими мьютексами и LRU-вытеснением.
+// Любое изменение индекса сбрасывает весь кеш: от числа документов,
+// средней длины документа и модели оценки зависит оценка любого запроса,
+// а не только запросов со словами изменённого документа. Изменения через
+// кеш очищают его сразу, а записи, пережившие изменение в обход кеша,
+// отбраковываются по эпохе индекса (SearchServer::GetIndexEpoch).
+// Поиск можно вызывать из нескольких потоков, но не во время изменений.
+class QueryCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit QueryCache(SearchServer& search_server, size_t capacity = DEFAULT_CAPACITY);
+
+    vector<Document> FindTopDocuments(string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    void AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings);
+    void RemoveDocument(int document_id);
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+    void SetRankingModel(RankingModel model, const Bm25Params& params = {});
+    void Clear();
+
+    uint64_t GetHitCount() const;
+    uint64_t GetMissCount() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        string key;
+        uint64_t index_epoch;
+        vector<Document> documents;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        // от недавно использованных к давним
+        std::list<Entry> entries;
+        // ключи ссылаются на строки в entries
+        unordered_map<string_view, std::list<Entry>::iterator> index;
+    };
+
+    static string MakeKey(const SearchServer::Query& query, DocumentStatus status, size_t max_count);
+
+    SearchServer& search_server_;
+    size_t shard_capacity_;
+    mutable std::array<Shard, SHARD_COUNT> shards_;
+    mutable std::atomic<uint64_t> hit_count_ = 0;
+    mutable std::atomic<uint64_t> miss_count_ = 0;
+};
@@ -0,0 +1,82 @@
+#include "query_stats.h"
+
+QueryStats& QueryStats::operator+=(const QueryStats& other) {
+    postings_scanned += other.postings_scanned;
+    documents_scored += other.documents_scored;
+    filtered_by_predicate += other.filtered_by_predicate;
+    filtered_by_minus_words += other.filtered_by_minus_words;
+    candidates_sorted += other.candidates_sorted;
+    parse_ns += other.parse_ns;
+    lookup_ns += other.lookup_ns;
+    traversal_ns += other.traversal_ns;
+    selection_ns += other.selection_ns;
+    total_ns += other.total_ns;
+    return *this;
+}
+
+void Log2Histogram::Add(uint64_t value) {
+    size_t bucket = 0;
+    for (; value != 0; value >>= 1) {
+        ++bucket;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Log2Histogram::Clear() {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Log2Histogram::GetCount() const {
+    uint64_t count = 0;
+    for (const std::atomic<uint64_t>& bucket : buckets_) {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+uint64_t Log2Histogram::GetBucketCount(size_t bucket) const {
+    return buckets_[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t Log2Histogram::GetBucketBound(size_t bucket) {
+    if (bucket == 0) {
+        return 0;
+    }
+    return bucket == BUCKET_COUNT - 1 ? UINT64_MAX : (uint64_t(1) << bucket) - 1;
+}
+
+uint64_t Log2Histogram::GetQuantileBound(double quantile) const {
+    // корзины читаются по одной, поэтому параллельные добавления
+    // могут сдвинуть ответ на корзину
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t total = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        counts[bucket] = GetBucketCount(bucket);
+        total += counts[bucket];
+    }
+    const double target = quantile * total;
+    uint64_t count = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        count += counts[bucket];
+        if (count > 0 && count >= target) {
+            return GetBucketBound(bucket);
+        }
+    }
+    return 0;
+}
+
+void QueryHistograms::Add(const QueryStats& stats) {
+    total_ns.Add(stats.total_ns);
+    postings_scanned.Add(stats.postings_scanned);
+    documents_scored.Add(stats.documents_scored);
+    candidates_sorted.Add(stats.candidates_sorted);
+}
+
+void QueryHistograms::Clear() {
+    total_ns.Clear();
+    postings_scanned.Clear();
+    documents_scored.Clear();
+    candidates_sorted.Clear();
+}
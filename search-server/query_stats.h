@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Сборка с SEARCH_SERVER_NO_STATS убирает сбор статистики запросов:
+// счётчики и замеры времени не компилируются, гистограммы остаются пустыми.
+#if defined(SEARCH_SERVER_NO_STATS)
+constexpr bool QUERY_STATS_ENABLED = false;
+#else
+constexpr bool QUERY_STATS_ENABLED = true;
+#endif
+
+// Счётчики и время этапов одного запроса FindTopDocuments.
+// При параллельном поиске счётчики и время обхода и отбора в диапазонах
+// складываются по всем потокам.
+struct QueryStats {
+    // прочитанные вхождения плюс- и минус-слов
+    uint64_t postings_scanned = 0;
+    // документы, получившие релевантность
+    uint64_t documents_scored = 0;
+    uint64_t filtered_by_predicate = 0;
+    uint64_t filtered_by_minus_words = 0;
+    // документы, предложенные выдаче
+    uint64_t candidates_sorted = 0;
+
+    // время в наносекундах: разбор запроса, поиск списков слов и IDF,
+    // обход списков с фильтрами и накоплением, отбор и сортировка лучших
+    uint64_t parse_ns = 0;
+    uint64_t lookup_ns = 0;
+    uint64_t traversal_ns = 0;
+    uint64_t selection_ns = 0;
+    uint64_t total_ns = 0;
+
+    QueryStats& operator+=(const QueryStats& other);
+};
+
+// Гистограмма по степеням двойки: в корзине 0 нули, в корзине k
+// значения [2^(k-1), 2^k). Значения добавляются без блокировок
+// из любых потоков, читать гистограмму можно в любой момент.
+class Log2Histogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 65;
+
+    void Add(uint64_t value);
+    void Clear();
+
+    uint64_t GetCount() const;
+    uint64_t GetBucketCount(size_t bucket) const;
+    // наибольшее значение корзины
+    static uint64_t GetBucketBound(size_t bucket);
+    // граница корзины, до которой включительно лежит доля quantile значений
+    uint64_t GetQuantileBound(double quantile) const;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+};
+
+// сводные гистограммы всех запросов сервера
+struct QueryHistograms {
+    Log2Histogram total_ns;
+    Log2Histogram postings_scanned;
+    Log2Histogram documents_scored;
+    Log2Histogram candidates_sorted;
+
+    void Add(const QueryStats& stats);
+    void Clear();
+};
+
+// Замер этапов запроса; без статистики ничего не делает
+class StageTimer {
+public:
+    StageTimer() {
+        Restart();
+    }
+
+    void Restart() {
+        if constexpr (QUERY_STATS_ENABLED) {
+            mark_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    // прибавляет к stage_ns время с прошлой отметки и ставит новую
+    void Lap(uint64_t& stage_ns) {
+        if constexpr (QUERY_STATS_ENABLED) {
+            const auto now = std::chrono::steady_clock::now();
+            stage_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark_).count();
+            mark_ = now;
+        }
+    }
+
+private:
+    std::chrono::steady_clock::time_point mark_;
+};
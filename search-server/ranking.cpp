@@ -0,0 +1,49 @@
+#include "ranking.h"
+#include <array>
+#include <cmath>
+
+namespace {
+
+const int64_t LOG_TABLE_SIZE = 4096;
+
+const std::array<double, LOG_TABLE_SIZE>& GetLogTable() {
+    static const std::array<double, LOG_TABLE_SIZE> table = [] {
+        std::array<double, LOG_TABLE_SIZE> result{};
+        for (int64_t i = 0; i < LOG_TABLE_SIZE; ++i) {
+            result[i] = std::log(static_cast<double>(i));
+        }
+        return result;
+    }();
+    return table;
+}
+
+} // namespace
+
+double LogOfCount(int64_t count) {
+    if (count >= 0 && count < LOG_TABLE_SIZE) {
+        return GetLogTable()[count];
+    }
+    return std::log(static_cast<double>(count));
+}
+
+InverseDocumentFreq::InverseDocumentFreq(RankingModel model, int document_count)
+    : model_(model)
+    , document_count_(document_count)
+    , log_document_count_(LogOfCount(document_count)) {
+}
+
+double InverseDocumentFreq::operator()(int document_freq) const {
+    if (model_ == RankingModel::BM25) {
+        return std::log(1.0 + (document_count_ - document_freq + 0.5) / (document_freq + 0.5));
+    }
+    return log_document_count_ - LogOfCount(document_freq);
+}
+
+Bm25Scorer::Bm25Scorer(const Bm25Params& params, double average_length)
+    : k1_plus_one_(params.k1 + 1.0)
+    , per_word_(average_length > 0.0 ? params.k1 * params.b / average_length : 0.0) {
+}
+
+double Bm25Scorer::GetLengthNorm(const Bm25Params& params, int length) {
+    return length > 0 ? params.k1 * (1.0 - params.b) / length : 0.0;
+}
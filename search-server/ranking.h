@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+
+// Способ оценки релевантности документа слову запроса.
+// TF_IDF - частота слова в документе, умноженная на log(N / df).
+// BM25 - насыщение по числу вхождений с поправкой на длину документа:
+// idf * f * (k1 + 1) / (f + k1 * (1 - b + b * length / avgdl)),
+// где f - число вхождений слова, idf = log(1 + (N - df + 0.5) / (df + 0.5)).
+enum class RankingModel {
+    TF_IDF,
+    BM25,
+};
+
+struct Bm25Params {
+    double k1 = 1.2;
+    double b = 0.75;
+};
+
+// натуральный логарифм числа; небольшие числа берутся из таблицы
+double LogOfCount(int64_t count);
+
+// IDF слов одного запроса: всё, что зависит только от числа документов,
+// считается один раз в конструкторе
+class InverseDocumentFreq {
+public:
+    InverseDocumentFreq(RankingModel model, int document_count);
+
+    double operator()(int document_freq) const;
+
+private:
+    RankingModel model_;
+    int document_count_;
+    double log_document_count_;
+};
+
+// Оценка BM25 для одного запроса. После деления на длину документа
+// знаменатель равен tf + k1 * (1 - b) / length + k1 * b / avgdl: первое
+// слагаемое после tf зависит только от документа и хранится у него
+// (GetLengthNorm), второе считается один раз на запрос, так что для
+// каждого вхождения остаются сложения, умножения и одно деление
+class Bm25Scorer {
+public:
+    Bm25Scorer(const Bm25Params& params, double average_length);
+
+    // поправка документа из length слов на длину при параметрах params
+    static double GetLengthNorm(const Bm25Params& params, int length);
+
+    // term_freq - доля слова среди слов документа, length_norm - его GetLengthNorm
+    double operator()(double term_freq, double length_norm, double inverse_document_freq) const {
+        return inverse_document_freq * term_freq * k1_plus_one_ / (term_freq + length_norm + per_word_);
+    }
+
+    // Наибольший вклад слова с долей не больше term_freq в документе любой
+    // длины: вклад убывает с поправкой на длину, поэтому он не больше
+    // значения при нулевой поправке.
+    double GetUpperBound(double term_freq, double inverse_document_freq) const {
+        if (term_freq <= 0.0) {
+            return 0.0;
+        }
+        return (*this)(term_freq, 0.0, inverse_document_freq);
+    }
+
+private:
+    double k1_plus_one_;
+    double per_word_;
+};
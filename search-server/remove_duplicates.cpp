@@ -1,36 +1,66 @@
 #include "remove_duplicates.h"
+#include <algorithm>
+#include <execution>
 
-void RemoveDuplicates(SearchServer& search_server)
-{
+vector<int> FindDuplicates(const SearchServer& search_server, double similarity) {
+    const DuplicateDetector fingerprinter(similarity);
+    const vector<int> document_ids(search_server.begin(), search_server.end());
 
-    std::set<std::set<std::string>> dupl;
-    std::set<std::string> unique;
-    std::set<int> id_delete;
+    vector<DuplicateDetector::Fingerprint> fingerprints(document_ids.size());
+    transform(std::execution::par, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+        [&search_server, &fingerprinter](int document_id) {
+            return fingerprinter.MakeFingerprint(search_server.GetDocumentWords(document_id));
+        });
 
-
-    for (const int document_id : search_server)
-    {
-        std::map<std::string, double> array = search_server.GetWordFrequencies(document_id);
-
-
-        transform(begin(array), end(array), inserter(unique, unique.begin()), [](auto String) { return String.first; });
-
-
-        if (!dupl.count(unique))
-        {
-            dupl.emplace(unique);
+    // проход по возрастанию id: из группы дубликатов остаётся меньший id
+    DuplicateDetector detector(similarity);
+    vector<int> duplicates;
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        if (detector.FindDuplicate(fingerprints[i]) != DuplicateDetector::NO_DUPLICATE) {
+            duplicates.push_back(document_ids[i]);
         }
-        else
-        {
-            id_delete.emplace(document_id);
+        else {
+            detector.Add(document_ids[i], move(fingerprints[i]));
         }
-        unique.clear();
     }
-    for (auto& id : id_delete)
-    {
-        std::cout << "Found duplicate document id " << id << std::endl;
-        search_server.RemoveDocument(id);
+    return duplicates;
+}
+
+void RemoveDuplicates(SearchServer& search_server, double similarity) {
+    for (const int document_id : FindDuplicates(search_server, similarity)) {
+        cout << "Found duplicate document id "s << document_id << endl;
+        search_server.RemoveDocument(document_id);
+    }
+}
+
+DuplicateFilter::DuplicateFilter(SearchServer& search_server, double similarity)
+    : search_server_(search_server)
+    , detector_(similarity) {
+    for (const int document_id : search_server_) {
+        detector_.Add(document_id, detector_.MakeFingerprint(search_server_.GetDocumentWords(document_id)));
     }
 }
 
+int DuplicateFilter::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    vector<string_view> words = SplitIntoWords(document);
+    words.erase(remove_if(words.begin(), words.end(), [this](string_view word) {
+        return search_server_.IsStopWord(word);
+        }), words.end());
 
+    DuplicateDetector::Fingerprint fingerprint = detector_.MakeFingerprint(words);
+    const int duplicate_id = detector_.FindDuplicate(fingerprint);
+    if (duplicate_id != DuplicateDetector::NO_DUPLICATE) {
+        return duplicate_id;
+    }
+    search_server_.AddDocument(document_id, document, status, ratings);
+    // document живёт только до возврата, отпечаток хранит те же слова из сервера
+    fingerprint.words = search_server_.GetDocumentWords(document_id);
+    sort(fingerprint.words.begin(), fingerprint.words.end());
+    detector_.Add(document_id, move(fingerprint));
+    return DuplicateDetector::NO_DUPLICATE;
+}
+
+void DuplicateFilter::RemoveDocument(int document_id) {
+    search_server_.RemoveDocument(document_id);
+    detector_.Remove(document_id);
+}
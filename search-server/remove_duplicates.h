@@ -1,4 +1,24 @@
 #pragma once
+#include "duplicate_detector.h"
 #include "search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
+// Возвращает по возрастанию id документы, дублирующие документ с меньшим id.
+// Отпечатки документов строятся параллельно. similarity - как в DuplicateDetector.
+vector<int> FindDuplicates(const SearchServer& search_server, double similarity = 1.0);
+void RemoveDuplicates(SearchServer& search_server, double similarity = 1.0);
+
+// Отсекает дубликаты при добавлении, без полного прохода по серверу.
+// Документы должны добавляться и удаляться только через фильтр.
+class DuplicateFilter {
+public:
+    explicit DuplicateFilter(SearchServer& search_server, double similarity = 1.0);
+
+    // id документа, дубликатом которого является новый документ, или
+    // DuplicateDetector::NO_DUPLICATE, если документ добавлен в сервер
+    int AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+private:
+    SearchServer& search_server_;
+    DuplicateDetector detector_;
+};
@@ -1,40 +1,157 @@
 #include "request_queue.h"
+#include <algorithm>
 
-RequestQueue::RequestQueue(const SearchServer& search_server)
+RequestQueue::RequestQueue(const SearchServer& search_server, size_t worker_count, size_t max_pending_count,
+    std::chrono::steady_clock::duration window)
     : search_server_(search_server)
-    , no_results_requests_(0)
-    , current_time_(0) {
+    , max_pending_count_(std::max<size_t>(max_pending_count, 1))
+    , requests_(window)
+    , no_result_requests_(window) {
+    worker_count = std::max<size_t>(worker_count, 1);
+    workers_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this] { RunWorker(); });
+    }
+}
+
+RequestQueue::~RequestQueue() {
+    {
+        std::lock_guard guard(queue_mutex_);
+        stopping_ = true;
+    }
+    has_jobs_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
 }
 
-vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
-    const auto result = search_server_.FindTopDocuments(raw_query);
-    AddRequest(result.size());
-    return result;
+vector<Document> RequestQueue::AddFindRequest(string_view raw_query) {
+    return FindAndRecord(raw_query, DocumentStatus::ACTUAL);
 }
 
-vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-    const auto result = search_server_.FindTopDocuments(raw_query, status);
-    AddRequest(result.size());
-    return result;
+vector<Document> RequestQueue::AddFindRequest(string_view raw_query, DocumentStatus status) {
+    return FindAndRecord(raw_query, status);
+}
+
+std::future<vector<Document>> RequestQueue::AddFindRequestAsync(string_view raw_query) {
+    return AddFindRequestAsync(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::future<vector<Document>> RequestQueue::AddFindRequestAsync(string_view raw_query, DocumentStatus status) {
+    auto search = MakeSearch(raw_query, status);
+    auto future = search.get_future();
+    Push(std::packaged_task<void()>(std::move(search)));
+    return future;
+}
+
+std::optional<std::future<vector<Document>>> RequestQueue::TryAddFindRequestAsync(string_view raw_query,
+    DocumentStatus status) {
+    auto search = MakeSearch(raw_query, status);
+    auto future = search.get_future();
+    std::packaged_task<void()> job(std::move(search));
+    if (!TryPush(job)) {
+        return std::nullopt;
+    }
+    return future;
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return no_results_requests_;
+    return no_result_requests_.Get(Clock::now());
+}
+
+int RequestQueue::GetRequestCount() const {
+    return requests_.Get(Clock::now());
+}
+
+size_t RequestQueue::GetPendingCount() const {
+    std::lock_guard guard(queue_mutex_);
+    return jobs_.size();
+}
+
+void RequestQueue::Push(std::packaged_task<void()> job) {
+    {
+        std::unique_lock lock(queue_mutex_);
+        has_space_.wait(lock, [this] { return jobs_.size() < max_pending_count_; });
+        jobs_.push_back(std::move(job));
+    }
+    has_jobs_.notify_one();
 }
 
-void RequestQueue::AddRequest(int results_num) {
-    // новый запрос - новая секунда
-    ++current_time_;
-    // удаляем все результаты поиска, которые устарели
-    while (!requests_.empty() && min_in_day_ <= current_time_ - requests_.front().timestamp) {
-        if (0 == requests_.front().results) {
-            --no_results_requests_;
+bool RequestQueue::TryPush(std::packaged_task<void()>& job) {
+    {
+        std::lock_guard guard(queue_mutex_);
+        if (jobs_.size() >= max_pending_count_) {
+            return false;
         }
-        requests_.pop_front();
+        jobs_.push_back(std::move(job));
     }
-    // сохраняем новый результат поиска
-    requests_.push_back({ current_time_, results_num });
+    has_jobs_.notify_one();
+    return true;
+}
+
+void RequestQueue::RunWorker() {
+    while (true) {
+        std::packaged_task<void()> job;
+        {
+            std::unique_lock lock(queue_mutex_);
+            has_jobs_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            // при остановке очередь сначала дорабатывается
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        has_space_.notify_one();
+        // исключение поиска попадает в future
+        job();
+    }
+}
+
+void RequestQueue::AddRequest(size_t results_num) {
+    const auto now = Clock::now();
+    requests_.Add(now);
     if (0 == results_num) {
-        ++no_results_requests_;
+        no_result_requests_.Add(now);
+    }
+}
+
+RequestQueue::WindowCounter::WindowCounter(Clock::duration window)
+    : interval_(std::max<Clock::duration>(window / INTERVAL_COUNT, Clock::duration(1)))
+    , cells_(INTERVAL_COUNT) {
+    // номер интервала 0 в пустой ячейке не должен совпасть с текущим
+    for (std::atomic<uint64_t>& cell : cells_) {
+        cell.store(static_cast<uint64_t>(GetInterval(Clock::now()) - static_cast<uint32_t>(INTERVAL_COUNT)) << 32, std::memory_order_relaxed);
+    }
+}
+
+uint32_t RequestQueue::WindowCounter::GetInterval(Clock::time_point time) const {
+    return static_cast<uint32_t>(time.time_since_epoch() / interval_);
+}
+
+void RequestQueue::WindowCounter::Add(Clock::time_point time) {
+    const uint32_t interval = GetInterval(time);
+    std::atomic<uint64_t>& cell = cells_[interval % INTERVAL_COUNT];
+    uint64_t value = cell.load(std::memory_order_relaxed);
+    while (true) {
+        const uint64_t next = static_cast<uint32_t>(value >> 32) == interval
+            ? value + 1
+            : (static_cast<uint64_t>(interval) << 32) | 1;
+        if (cell.compare_exchange_weak(value, next, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+int RequestQueue::WindowCounter::Get(Clock::time_point time) const {
+    const uint32_t current = GetInterval(time);
+    uint64_t count = 0;
+    for (const std::atomic<uint64_t>& cell : cells_) {
+        const uint64_t value = cell.load(std::memory_order_relaxed);
+        // учитываются интервалы, попадающие в окно, заканчивающееся текущим
+        if (static_cast<uint32_t>(current - static_cast<uint32_t>(value >> 32)) < INTERVAL_COUNT) {
+            count += value & 0xffffffffu;
+        }
     }
+    return static_cast<int>(count);
 }
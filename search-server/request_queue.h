@@ -1,38 +1,175 @@
 #pragma once
-#include <iostream>
-#include <vector>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 #include "document.h"
 #include "search_server.h"
 
+// Очередь поисковых запросов к серверу. Запросы можно подавать из
+// нескольких потоков: результат приходит через future или обратный вызов,
+// а выполняют запросы рабочие потоки очереди. Очередь ограничена:
+// при заполнении AddFindRequestAsync ждёт освобождения места,
+// а TryAddFindRequestAsync сразу отказывает, поэтому всплеск запросов
+// не копит бесконечную очередь и не растягивает время ответа.
+// Статистика считается за скользящее окно реального времени (по умолчанию
+// сутки) без блокировок и доступна в любой момент. Сервер не должен
+// изменяться, пока очередь работает с ним.
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    static constexpr size_t DEFAULT_MAX_PENDING_COUNT = 1024;
+
+    explicit RequestQueue(const SearchServer& search_server, size_t worker_count = NUMTHREAD,
+        size_t max_pending_count = DEFAULT_MAX_PENDING_COUNT,
+        std::chrono::steady_clock::duration window = std::chrono::hours(24));
+    // дожидается выполнения уже принятых запросов
+    ~RequestQueue();
+
+    RequestQueue(const RequestQueue&) = delete;
+    RequestQueue& operator=(const RequestQueue&) = delete;
+
+    // синхронный поиск в потоке вызывающего, учитывается в статистике
+    template <typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(string_view raw_query, DocumentPredicate document_predicate);
+    vector<Document> AddFindRequest(string_view raw_query, DocumentStatus status);
+    vector<Document> AddFindRequest(string_view raw_query);
+
+    // асинхронный поиск; ждёт, пока в очереди не появится место
+    template <typename DocumentPredicate>
+    std::future<std::vector<Document>> AddFindRequestAsync(string_view raw_query, DocumentPredicate document_predicate);
+    std::future<std::vector<Document>> AddFindRequestAsync(string_view raw_query, DocumentStatus status);
+    std::future<std::vector<Document>> AddFindRequestAsync(string_view raw_query);
+
+    // callback(documents, error) вызывается в рабочем потоке;
+    // error не пуст, если поиск завершился исключением
+    template <typename DocumentPredicate, typename Callback>
+    void AddFindRequestAsync(string_view raw_query, DocumentPredicate document_predicate, Callback callback);
 
-    // сделаем "обертки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
+    // как AddFindRequestAsync, но при заполненной очереди возвращает nullopt
     template <typename DocumentPredicate>
-    std::vector<Document> AddFindRequest(const string& raw_query, DocumentPredicate document_predicate);
-    vector<Document> AddFindRequest(const string& raw_query, DocumentStatus status);
-    vector<Document> AddFindRequest(const string& raw_query);
+    std::optional<std::future<std::vector<Document>>> TryAddFindRequestAsync(string_view raw_query,
+        DocumentPredicate document_predicate);
+    std::optional<std::future<std::vector<Document>>> TryAddFindRequestAsync(string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL);
+
+    // запросы без результатов и все выполненные запросы за окно
     int GetNoResultRequests() const;
+    int GetRequestCount() const;
+    // принятые, но ещё не начатые запросы
+    size_t GetPendingCount() const;
 
 private:
-    struct QueryResult {
-        uint64_t timestamp;
-        int results;
+    using Clock = std::chrono::steady_clock;
+
+    // Окно разбито на интервалы. Ячейка интервала хранит в одном атомарном
+    // слове номер интервала (старшие 32 бита) и счётчик (младшие), поэтому
+    // устаревшая ячейка обнуляется и увеличивается одной операцией CAS.
+    // Окно сдвигается по целым интервалам.
+    class WindowCounter {
+    public:
+        static constexpr size_t INTERVAL_COUNT = 1440;
+
+        explicit WindowCounter(Clock::duration window);
+
+        void Add(Clock::time_point time);
+        int Get(Clock::time_point time) const;
+
+    private:
+        uint32_t GetInterval(Clock::time_point time) const;
+
+        Clock::duration interval_;
+        std::vector<std::atomic<uint64_t>> cells_;
     };
-    std::deque<QueryResult> requests_;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAndRecord(string_view raw_query, DocumentPredicate document_predicate);
+    // запрос копируется: строка вызывающего может не дожить до выполнения
+    template <typename DocumentPredicate>
+    std::packaged_task<std::vector<Document>()> MakeSearch(string_view raw_query, DocumentPredicate document_predicate);
+    // ждёт места в очереди
+    void Push(std::packaged_task<void()> job);
+    // false, если очередь заполнена
+    bool TryPush(std::packaged_task<void()>& job);
+    void RunWorker();
+    void AddRequest(size_t results_num);
+
     const SearchServer& search_server_;
-    int no_results_requests_;
-    uint64_t current_time_;
-    const static int min_in_day_ = 1440;
+    const size_t max_pending_count_;
+
+    mutable std::mutex queue_mutex_;
+    std::condition_variable has_jobs_;
+    std::condition_variable has_space_;
+    std::deque<std::packaged_task<void()>> jobs_;
+    bool stopping_ = false;
+
+    WindowCounter requests_;
+    WindowCounter no_result_requests_;
 
-    void AddRequest(int results_num);
+    std::vector<std::thread> workers_;
 };
 
 template <typename DocumentPredicate>
-std::vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentPredicate document_predicate) {
-    const auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
+std::vector<Document> RequestQueue::FindAndRecord(string_view raw_query, DocumentPredicate document_predicate) {
+    auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
     AddRequest(result.size());
     return result;
 }
+
+template <typename DocumentPredicate>
+std::vector<Document> RequestQueue::AddFindRequest(string_view raw_query, DocumentPredicate document_predicate) {
+    return FindAndRecord(raw_query, document_predicate);
+}
+
+template <typename DocumentPredicate>
+std::packaged_task<std::vector<Document>()> RequestQueue::MakeSearch(string_view raw_query,
+    DocumentPredicate document_predicate) {
+    return std::packaged_task<std::vector<Document>()>([this, document_predicate, query = std::string(raw_query)] {
+        return FindAndRecord(query, document_predicate);
+        });
+}
+
+template <typename DocumentPredicate>
+std::future<std::vector<Document>> RequestQueue::AddFindRequestAsync(string_view raw_query,
+    DocumentPredicate document_predicate) {
+    auto search = MakeSearch(raw_query, document_predicate);
+    auto future = search.get_future();
+    Push(std::packaged_task<void()>(std::move(search)));
+    return future;
+}
+
+template <typename DocumentPredicate, typename Callback>
+void RequestQueue::AddFindRequestAsync(string_view raw_query, DocumentPredicate document_predicate, Callback callback) {
+    Push(std::packaged_task<void()>([this, document_predicate, callback = std::move(callback),
+        query = std::string(raw_query)]() mutable {
+        std::vector<Document> documents;
+        std::exception_ptr error;
+        try {
+            documents = FindAndRecord(query, document_predicate);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        callback(std::move(documents), error);
+        }));
+}
+
+template <typename DocumentPredicate>
+std::optional<std::future<std::vector<Document>>> RequestQueue::TryAddFindRequestAsync(string_view raw_query,
+    DocumentPredicate document_predicate) {
+    auto search = MakeSearch(raw_query, document_predicate);
+    auto future = search.get_future();
+    std::packaged_task<void()> job(std::move(search));
+    if (!TryPush(job)) {
+        return std::nullopt;
+    }
+    return future;
+}
@@ -0,0 +1,47 @@
+#include "score_accumulator.h"
+
+void ScoreAccumulator::Reset(size_t size) {
+    for (const size_t slot : touched_) {
+        flags_[slot] = 0;
+    }
+    touched_.clear();
+    if (flags_.size() < size) {
+        flags_.resize(size, 0);
+        scores_.resize(size);
+    }
+}
+
+namespace {
+    struct ThreadAccumulator {
+        ScoreAccumulator accumulator;
+        bool busy = false;
+    };
+
+    thread_local ThreadAccumulator thread_accumulator;
+}
+
+AccumulatorLease::AccumulatorLease(size_t size) {
+    if (thread_accumulator.busy) {
+        own_ = std::make_unique<ScoreAccumulator>();
+        accumulator_ = own_.get();
+    }
+    else {
+        thread_accumulator.busy = true;
+        accumulator_ = &thread_accumulator.accumulator;
+    }
+    accumulator_->Reset(size);
+}
+
+AccumulatorLease::~AccumulatorLease() {
+    if (!own_) {
+        thread_accumulator.busy = false;
+    }
+}
+
+ScoreAccumulator& AccumulatorLease::operator*() {
+    return *accumulator_;
+}
+
+ScoreAccumulator* AccumulatorLease::operator->() {
+    return accumulator_;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Плотный накопитель релевантности на время одного запроса.
+// Ячейки индексируются порядковым номером документа внутри диапазона,
+// сброс проходит только по затронутым ячейкам.
+class ScoreAccumulator {
+public:
+    // готовит накопитель к запросу по size ячейкам
+    void Reset(size_t size);
+
+    bool IsTouched(size_t slot) const;
+    bool IsExcluded(size_t slot) const;
+
+    // документ содержит минус-слово или не прошёл фильтр
+    void Exclude(size_t slot);
+    void Add(size_t slot, double score);
+
+    // func(slot, score) для каждой не исключённой затронутой ячейки
+    template <typename Func>
+    void ForEach(Func func) const;
+
+    // буфер для маски фильтра документов диапазона (см. document_filter.h)
+    std::vector<uint8_t>& GetFilterMask();
+
+private:
+    static constexpr uint8_t TOUCHED = 1;
+    static constexpr uint8_t EXCLUDED = 2;
+
+    std::vector<double> scores_;
+    std::vector<uint8_t> flags_;
+    std::vector<size_t> touched_;
+    std::vector<uint8_t> filter_mask_;
+};
+
+// Накопитель, закреплённый за текущим потоком: повторные запросы
+// в этом потоке не выделяют память. При вложенном использовании
+// выдаётся временный накопитель.
+class AccumulatorLease {
+public:
+    explicit AccumulatorLease(size_t size);
+    ~AccumulatorLease();
+
+    AccumulatorLease(const AccumulatorLease&) = delete;
+    AccumulatorLease& operator=(const AccumulatorLease&) = delete;
+
+    ScoreAccumulator& operator*();
+    ScoreAccumulator* operator->();
+
+private:
+    ScoreAccumulator* accumulator_;
+    std::unique_ptr<ScoreAccumulator> own_;
+};
+
+inline bool ScoreAccumulator::IsTouched(size_t slot) const {
+    return flags_[slot] & TOUCHED;
+}
+
+inline bool ScoreAccumulator::IsExcluded(size_t slot) const {
+    return flags_[slot] & EXCLUDED;
+}
+
+inline void ScoreAccumulator::Exclude(size_t slot) {
+    if (!(flags_[slot] & TOUCHED)) {
+        touched_.push_back(slot);
+    }
+    flags_[slot] |= TOUCHED | EXCLUDED;
+}
+
+inline void ScoreAccumulator::Add(size_t slot, double score) {
+    if (!(flags_[slot] & TOUCHED)) {
+        flags_[slot] = TOUCHED;
+        scores_[slot] = 0.0;
+        touched_.push_back(slot);
+    }
+    scores_[slot] += score;
+}
+
+inline std::vector<uint8_t>& ScoreAccumulator::GetFilterMask() {
+    return filter_mask_;
+}
+
+template <typename Func>
+void ScoreAccumulator::ForEach(Func func) const {
+    for (const size_t slot : touched_) {
+        if (!(flags_[slot] & EXCLUDED)) {
+            func(slot, scores_[slot]);
+        }
+    }
+}
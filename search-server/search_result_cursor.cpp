@@ -0,0 +1,41 @@
+#include "search_result_cursor.h"
+#include <algorithm>
+#include <stdexcept>
+#include "top_documents.h"
+
+SearchResultCursor::SearchResultCursor(const SearchServer& search_server, string_view raw_query,
+    DocumentStatus status, size_t page_size)
+    : SearchResultCursor(search_server, raw_query, StatusFilter{ status }, page_size) {
+}
+
+SearchResultCursor::Page SearchResultCursor::GetPage(size_t page_index) {
+    const size_t first = page_index < GetPageCount() ? page_index * page_size_ : documents_.size();
+    const size_t last = std::min(first + page_size_, documents_.size());
+    if (last > sorted_count_) {
+        // лучшие из оставшихся отбираются за линейное время, затем сортируются
+        const auto sorted_end = documents_.begin() + sorted_count_;
+        std::nth_element(sorted_end, documents_.begin() + last - 1, documents_.end(), IsMoreRelevant);
+        std::sort(sorted_end, documents_.begin() + last, IsMoreRelevant);
+        sorted_count_ = last;
+    }
+    return { documents_.cbegin() + first, documents_.cbegin() + last };
+}
+
+size_t SearchResultCursor::GetDocumentCount() const {
+    return documents_.size();
+}
+
+size_t SearchResultCursor::GetPageCount() const {
+    return (documents_.size() + page_size_ - 1) / page_size_;
+}
+
+size_t SearchResultCursor::GetPageSize() const {
+    return page_size_;
+}
+
+size_t SearchResultCursor::CheckPageSize(size_t page_size) {
+    if (page_size == 0) {
+        throw invalid_argument("Page size must be positive"s);
+    }
+    return page_size;
+}
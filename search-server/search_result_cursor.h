@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include "document.h"
+#include "paginator.h"
+#include "search_server.h"
+
+// Постраничный просмотр результатов одного запроса. Запрос оценивается
+// один раз в конструкторе, дальше сервер не нужен. Документы
+// упорядочиваются по мере обращения к страницам: для страницы N
+// отбираются и сортируются только документы первых N + 1 страниц,
+// уже упорядоченные страницы не пересчитываются.
+class SearchResultCursor {
+public:
+    using Page = IteratorRange<std::vector<Document>::const_iterator>;
+
+    SearchResultCursor(const SearchServer& search_server, string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL, size_t page_size = MAX_RESULT_DOCUMENT_COUNT);
+
+    template <typename DocumentPredicate>
+    SearchResultCursor(const SearchServer& search_server, string_view raw_query, DocumentPredicate document_predicate,
+        size_t page_size = MAX_RESULT_DOCUMENT_COUNT);
+
+    // страница с номером page_index от нуля; за концом выдачи - пустая.
+    // Страница действительна, пока жив курсор.
+    Page GetPage(size_t page_index);
+
+    size_t GetDocumentCount() const;
+    size_t GetPageCount() const;
+    size_t GetPageSize() const;
+
+private:
+    static size_t CheckPageSize(size_t page_size);
+
+    size_t page_size_;
+    std::vector<Document> documents_;
+    // documents_[0, sorted_count_) - лучшие документы по порядку выдачи
+    size_t sorted_count_ = 0;
+};
+
+template <typename DocumentPredicate>
+SearchResultCursor::SearchResultCursor(const SearchServer& search_server, string_view raw_query,
+    DocumentPredicate document_predicate, size_t page_size)
+    : page_size_(CheckPageSize(page_size))
+    , documents_(search_server.FindMatchedDocuments(raw_query, document_predicate)) {
+}
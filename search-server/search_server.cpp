@@ -12,26 +12,213 @@ SearchServer::SearchServer(const string& stop_words_text)
 {
 }
 
+SearchServer::SearchServer(std::shared_ptr<const IndexSegment> segment)
+    : word_to_document_freqs_(segment)
+    , segment_(segment)
+    , document_count_(segment->GetDocumentCount())
+    , total_word_count_(static_cast<int64_t>(segment->GetWordCount()))
+    , ordinal_to_document_id_(segment->GetDocumentCount(), std::shared_ptr<const int>(segment, segment->GetDocumentIds()))
+    , documents_(segment->GetDocumentCount(), std::shared_ptr<const DocumentData>(segment, segment->GetDocuments()))
+    , document_statuses_(segment->GetDocumentCount(), nullptr)
+    , document_ratings_(segment->GetDocumentCount(), nullptr)
+    , document_length_norms_(segment->GetDocumentCount(), nullptr)
+    , document_terms_(segment->GetDocumentCount(), nullptr)
+    , document_texts_(segment->GetDocumentCount(), nullptr)
+    , document_arena_generations_(segment->GetDocumentCount(), nullptr)
+{
+    std::set<std::string, std::less<>> stop_words;
+    for (size_t i = 0; i < segment->GetStopWordCount(); ++i) {
+        stop_words.emplace(segment->GetStopWord(i));
+    }
+    stop_words_ = CowPtr<StopWordSet>(StopWordSet(stop_words));
+    // сегмент хранит данные документов записями, столбцы собираются при открытии
+    for (int ordinal = 0; ordinal < document_count_; ++ordinal) {
+        document_statuses_.Mutable(ordinal) = static_cast<uint8_t>(documents_[ordinal].status);
+        document_ratings_.Mutable(ordinal) = documents_[ordinal].rating;
+        document_length_norms_.Mutable(ordinal) = Bm25Scorer::GetLengthNorm(bm25_params_, documents_[ordinal].word_count);
+    }
+}
+
 void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
     const vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    if ((document_id < 0) || (FindOrdinal(document_id) != NO_ORDINAL)) {
         throw invalid_argument("Invalid document_id"s);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, std::string(document)});
-    
-    const auto words = SplitIntoWordsNoStop(documents_.at(document_id).word_);
+    static thread_local vector<string_view> words;
+    SplitIntoWordsNoStop(document, words);
+
+    const int ordinal = AcquireOrdinal(document_id);
+    SetDocumentData(ordinal, DocumentData{ ComputeAverageRating(ratings), status, static_cast<int>(words.size()) });
+    total_word_count_ += words.size();
+    if (keep_document_texts_) {
+        document_texts_.Mutable(ordinal) = std::make_shared<const string>(document);
+    }
 
+    // одинаковые слова после сортировки идут подряд
+    std::sort(words.begin(), words.end());
     const double inv_word_count = 1.0 / words.size();
-    for (string_view word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        word_freqs[document_id][word] += inv_word_count;
+
+    auto terms = std::make_shared<vector<TermFrequency>>();
+    for (auto it = words.begin(); it != words.end();) {
+        const string_view word = *it;
+        double term_freq = 0.0;
+        for (; it != words.end() && *it == word; ++it) {
+            term_freq += inv_word_count;
+        }
+        terms->push_back({ word_to_document_freqs_.Add(word, ordinal, term_freq, status), term_freq });
     }
+    document_terms_.Mutable(ordinal) = std::move(terms);
     
-    document_ids_.insert(document_id);
+    document_ids_.Update([document_id](set<int>& ids) {
+        ids.insert(document_id);
+        });
 }
 
-vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, status);
+namespace {
+
+// частичный индекс части пакета; документы нумеруются по месту в пакете
+struct PartialIndex {
+    // слова в порядке первого появления в части
+    vector<string_view> words;
+    unordered_map<string_view, uint32_t> word_indexes;
+    // по номеру слова в части: (номер документа в пакете, частота)
+    vector<vector<pair<size_t, double>>> postings;
+    // по документу части: (номер слова в части, частота)
+    vector<vector<pair<uint32_t, double>>> document_words;
+    // по номеру слова в части, заполняется при слиянии
+    vector<uint32_t> term_ids;
+    std::exception_ptr error;
+};
+
+} // namespace
+
+void SearchServer::AddDocuments(const vector<DocumentToAdd>& documents) {
+    {
+        unordered_set<int> batch_ids;
+        for (const DocumentToAdd& document : documents) {
+            if (document.id < 0 || FindOrdinal(document.id) != NO_ORDINAL || !batch_ids.insert(document.id).second) {
+                throw invalid_argument("Invalid document_id"s);
+            }
+        }
+    }
+
+    const size_t part_count = std::min<size_t>(documents.size(), std::max(1u, NUMTHREAD) * 4);
+    vector<PartialIndex> parts(part_count);
+    vector<int> word_counts(documents.size());
+    vector<size_t> part_indexes(part_count);
+    std::iota(part_indexes.begin(), part_indexes.end(), 0);
+    auto part_begin = [&documents, part_count](size_t part) {
+        return documents.size() * part / part_count;
+    };
+
+    std::for_each(std::execution::par, part_indexes.begin(), part_indexes.end(), [&](size_t part) {
+        PartialIndex& index = parts[part];
+        vector<string_view> words;
+        try {
+            for (size_t i = part_begin(part); i < part_begin(part + 1); ++i) {
+                SplitIntoWordsNoStop(documents[i].text, words);
+                word_counts[i] = static_cast<int>(words.size());
+                std::sort(words.begin(), words.end());
+                const double inv_word_count = 1.0 / words.size();
+                auto& document_words = index.document_words.emplace_back();
+                for (auto it = words.begin(); it != words.end();) {
+                    const string_view word = *it;
+                    double term_freq = 0.0;
+                    for (; it != words.end() && *it == word; ++it) {
+                        term_freq += inv_word_count;
+                    }
+                    const auto [word_it, inserted] = index.word_indexes.emplace(word, static_cast<uint32_t>(index.words.size()));
+                    if (inserted) {
+                        index.words.push_back(word);
+                        index.postings.emplace_back();
+                    }
+                    index.postings[word_it->second].push_back({ i, term_freq });
+                    document_words.push_back({ word_it->second, term_freq });
+                }
+            }
+        }
+        catch (...) {
+            index.error = std::current_exception();
+        }
+        });
+    for (const PartialIndex& index : parts) {
+        if (index.error) {
+            std::rethrow_exception(index.error);
+        }
+    }
+
+    // дальше ошибок нет: номера и id слов выдаются в том же порядке,
+    // что и при последовательном добавлении
+    vector<int> ordinals;
+    ordinals.reserve(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentToAdd& document = documents[i];
+        const int ordinal = AcquireOrdinal(document.id);
+        ordinals.push_back(ordinal);
+        SetDocumentData(ordinal, DocumentData{ ComputeAverageRating(document.ratings), document.status, word_counts[i] });
+        total_word_count_ += word_counts[i];
+        if (keep_document_texts_) {
+            document_texts_.Mutable(ordinal) = std::make_shared<const string>(document.text);
+        }
+    }
+
+    // списки слов пакета и части, где у слова есть вхождения
+    vector<StatusPostings*> batch_postings;
+    vector<vector<pair<size_t, uint32_t>>> batch_sources;
+    unordered_map<uint32_t, size_t> batch_term_indexes;
+    for (size_t part = 0; part < part_count; ++part) {
+        PartialIndex& index = parts[part];
+        index.term_ids.reserve(index.words.size());
+        for (uint32_t word_index = 0; word_index < index.words.size(); ++word_index) {
+            const uint32_t term_id = word_to_document_freqs_.AddTerm(index.words[word_index]);
+            index.term_ids.push_back(term_id);
+            const auto [it, inserted] = batch_term_indexes.emplace(term_id, batch_postings.size());
+            if (inserted) {
+                batch_postings.push_back(&word_to_document_freqs_.GetPostingsToAdd(term_id));
+                batch_sources.emplace_back();
+            }
+            batch_sources[it->second].push_back({ part, word_index });
+        }
+    }
+
+    vector<size_t> term_indexes(batch_postings.size());
+    std::iota(term_indexes.begin(), term_indexes.end(), 0);
+    std::for_each(std::execution::par, term_indexes.begin(), term_indexes.end(), [&](size_t term_index) {
+        StatusPostings& postings = *batch_postings[term_index];
+        for (const auto& [part, word_index] : batch_sources[term_index]) {
+            for (const auto& [document_index, term_freq] : parts[part].postings[word_index]) {
+                postings.Add(ordinals[document_index], term_freq, documents[document_index].status);
+            }
+        }
+        });
+
+    vector<shared_ptr<const vector<TermFrequency>>> terms(documents.size());
+    std::for_each(std::execution::par, part_indexes.begin(), part_indexes.end(), [&](size_t part) {
+        const PartialIndex& index = parts[part];
+        const size_t first = part_begin(part);
+        for (size_t i = 0; i < index.document_words.size(); ++i) {
+            auto document_terms = std::make_shared<vector<TermFrequency>>();
+            document_terms->reserve(index.document_words[i].size());
+            for (const auto& [word_index, term_freq] : index.document_words[i]) {
+                document_terms->push_back({ index.term_ids[word_index], term_freq });
+            }
+            terms[first + i] = std::move(document_terms);
+        }
+        });
+
+    for (size_t i = 0; i < documents.size(); ++i) {
+        document_terms_.Mutable(ordinals[i]) = std::move(terms[i]);
+    }
+    document_ids_.Update([&documents](set<int>& ids) {
+        for (const DocumentToAdd& document : documents) {
+            ids.insert(document.id);
+        }
+        });
+}
+
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_count,
+    RetrievalStrategy strategy, QueryStats* stats) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, max_count, strategy, stats);
 }
 
 
@@ -42,88 +229,145 @@ vector<Document> SearchServer::FindTopDocuments(string_view raw_query) const {
 
 
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return document_count_;
+}
+
+uint64_t SearchServer::GetIndexEpoch() const {
+    return index_epoch_;
+}
+
+const QueryHistograms& SearchServer::GetQueryHistograms() const {
+    return *query_histograms_;
+}
+
+void SearchServer::ClearQueryHistograms() {
+    query_histograms_->Clear();
+}
+
+void SearchServer::RecordQueryStats(const QueryStats& query_stats, QueryStats* stats) const {
+    if constexpr (QUERY_STATS_ENABLED) {
+        query_histograms_->Add(query_stats);
+        if (stats != nullptr) {
+            *stats = query_stats;
+        }
+    }
 }
 
 
 set<int>::const_iterator SearchServer::begin() const
 {
-    return document_ids_.begin();
+    return GetDocumentIds().begin();
 }
 
 set<int>::const_iterator SearchServer::end() const
 {
-    return document_ids_.end();
+    return GetDocumentIds().end();
 }
 
 set<int>::iterator SearchServer::begin()
 {
-    return document_ids_.begin();
+    return GetDocumentIds().begin();
 }
 
 set<int>::iterator SearchServer::end()
 {
-    return document_ids_.end();
+    return GetDocumentIds().end();
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    const int ordinal = GetOrdinal(document_id);
     const auto query = ParseQuery(raw_query);
+    const DocumentStatus status = documents_[ordinal].status;
     std::vector<std::string_view> matched_words;
     for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            return { matched_words, documents_.at(document_id).status };
+        const StatusPostings* postings = word_to_document_freqs_.Find(word);
+        if (postings != nullptr && postings->Contains(ordinal, status)) {
+            return { matched_words, status };
         }
     }
     for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+        const StatusPostings* postings = word_to_document_freqs_.Find(word);
+        if (postings != nullptr && postings->Contains(ordinal, status)) {
             matched_words.push_back(word);
         }
     }
 
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, status };
 }
 
 
-tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::sequenced_policy ex, string_view raw_query, int document_id) const {
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::sequenced_policy, string_view raw_query, int document_id) const {
     return MatchDocument(raw_query, document_id);
 }
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy policy, std::string_view raw_query, int document_id) const {
+    const int ordinal = GetOrdinal(document_id);
     const auto query = ParseQuery(raw_query, false);
+    const DocumentStatus status = documents_[ordinal].status;
     std::vector<std::string_view> matched_words;
     if (any_of(policy, query.minus_words.begin(), query.minus_words.end(), [&](auto word) {
-        if (word_to_document_freqs_.count(word)) {
-            if (word_to_document_freqs_.at(word).count(document_id)) {
-                return true;
-            }
-        }
-    return false;
-        }) == true) return { matched_words, documents_.at(document_id).status };
+        const StatusPostings* postings = word_to_document_freqs_.Find(word);
+        return postings != nullptr && postings->Contains(ordinal, status);
+        }) == true) return { matched_words, status };
 
         matched_words.resize(query.plus_words.size());
         auto end = copy_if(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), [&](auto word) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                return false;
-            }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            return true;
-        }
-        return false;
+            const StatusPostings* postings = word_to_document_freqs_.Find(word);
+            return postings != nullptr && postings->Contains(ordinal, status);
             });
 
         sort(matched_words.begin(), end);
         auto it = unique(matched_words.begin(), end);
         matched_words.erase(it, matched_words.end());
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, status };
+}
+
+vector<tuple<vector<string_view>, DocumentStatus>> SearchServer::MatchDocuments(string_view raw_query,
+    const vector<int>& document_ids) const {
+    vector<tuple<vector<string_view>, DocumentStatus>> result(document_ids.size());
+    vector<pair<int, size_t>> ordinals;
+    ordinals.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const int ordinal = GetOrdinal(document_ids[i]);
+        ordinals.emplace_back(ordinal, i);
+        std::get<1>(result[i]) = documents_[ordinal].status;
+    }
+    std::sort(ordinals.begin(), ordinals.end());
+
+    const auto query = ParseQuery(raw_query);
+    vector<bool> excluded(document_ids.size(), false);
+    for (const string_view word : query.minus_words) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            StatusPostings::Seeker seeker(*postings);
+            for (const auto& [ordinal, index] : ordinals) {
+                if (seeker.Contains(ordinal, documents_[ordinal].status)) {
+                    excluded[index] = true;
+                }
+            }
+        }
+    }
+    for (const string_view word : query.plus_words) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            StatusPostings::Seeker seeker(*postings);
+            for (const auto& [ordinal, index] : ordinals) {
+                if (!excluded[index] && seeker.Contains(ordinal, documents_[ordinal].status)) {
+                    std::get<0>(result[index]).push_back(word);
+                }
+            }
+        }
+    }
+    return result;
 }
 
 bool SearchServer::IsStopWord(const string_view word) const {
-    return stop_words_.count(word) > 0;
+    return stop_words_->Contains(word);
+}
+
+bool SearchServer::HasDocument(int document_id) const {
+    return FindOrdinal(document_id) != NO_ORDINAL;
+}
+
+SearchServer::Query SearchServer::NormalizeQuery(string_view raw_query) const {
+    return ParseQuery(raw_query);
 }
 
 bool SearchServer::IsValidWord(const string_view word) {
@@ -132,17 +376,16 @@ bool SearchServer::IsValidWord(const string_view word) {
         });
 }
 
-vector<string_view> SearchServer::SplitIntoWordsNoStop(const string_view text) const {
-    vector<string_view> words;
-    for (const string_view& word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw invalid_argument("Word "s + string(word) + " is invalid"s);
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+void SearchServer::SplitIntoWordsNoStop(const string_view text, vector<string_view>& words) const {
+    const size_t invalid_word = SplitIntoWords(text, words);
+    if (invalid_word < words.size()) {
+        throw invalid_argument("Word "s + string(words[invalid_word]) + " is invalid"s);
+    }
+    if (!stop_words_->Empty()) {
+        words.erase(remove_if(words.begin(), words.end(), [this](string_view word) {
+            return IsStopWord(word);
+            }), words.end());
     }
-    return words;
 }
 
 int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
@@ -175,7 +418,9 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
 
 SearchServer::Query SearchServer::ParseQuery(string_view text, bool flag) const {
     Query result;
-    for (string_view word : SplitIntoWords(text)) {
+    static thread_local vector<string_view> words;
+    SplitIntoWords(text, words);
+    for (const string_view word : words) {
         const auto query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
@@ -196,70 +441,528 @@ SearchServer::Query SearchServer::ParseQuery(string_view text, bool flag) const
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view& word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+InverseDocumentFreq SearchServer::PrepareScoring(QueryPostings& query_postings, int document_count, int64_t word_count) const {
+    if (ranking_model_ == RankingModel::BM25) {
+        query_postings.bm25.emplace(bm25_params_, document_count > 0 ? word_count * 1.0 / document_count : 0.0);
+    }
+    return InverseDocumentFreq(ranking_model_, document_count);
+}
+
+void SearchServer::AddStatistics(string_view raw_query, CollectionStatistics& statistics) const {
+    statistics.document_count += GetIndexedDocumentCount();
+    statistics.word_count += total_word_count_;
+    for (const string_view word : ParseQuery(raw_query).plus_words) {
+        const StatusPostings* postings = word_to_document_freqs_.Find(word);
+        statistics.document_freqs[word] += postings != nullptr ? static_cast<int>(postings->Size()) : 0;
+    }
+}
+
+void SearchServer::SetRankingModel(RankingModel model, const Bm25Params& params) {
+    ranking_model_ = model;
+    if (params.k1 != bm25_params_.k1 || params.b != bm25_params_.b) {
+        bm25_params_ = params;
+        for (size_t ordinal = 0; ordinal < documents_.size(); ++ordinal) {
+            document_length_norms_.Mutable(ordinal) = Bm25Scorer::GetLengthNorm(params, documents_[ordinal].word_count);
+        }
+    }
+    ++index_epoch_;
+}
+
+RankingModel SearchServer::GetRankingModel() const {
+    return ranking_model_;
+}
+
+SearchServer::QueryPostings SearchServer::FindQueryPostings(const Query& query, std::optional<DocumentStatus> status) const {
+    QueryPostings result;
+    const InverseDocumentFreq inverse_document_freq = PrepareScoring(result, GetIndexedDocumentCount(), total_word_count_);
+    for (const string_view word : query.plus_words) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            // IDF считается по документам всех статусов
+            AddPlusPostings(result, *postings, inverse_document_freq(static_cast<int>(postings->Size())), status);
+        }
+    }
+    for (const string_view word : query.minus_words) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            AddMinusPostings(result, *postings, status);
+        }
+    }
+    return result;
+}
+
+SearchServer::QueryPostings SearchServer::FindQueryPostings(const Query& query, const TermPostingsCache& terms,
+    std::optional<DocumentStatus> status) const {
+    QueryPostings result;
+    PrepareScoring(result, GetIndexedDocumentCount(), total_word_count_);
+    for (const string_view word : query.plus_words) {
+        const auto& [postings, inverse_document_freq] = terms.at(word);
+        if (postings != nullptr) {
+            AddPlusPostings(result, *postings, inverse_document_freq, status);
+        }
+    }
+    for (const string_view word : query.minus_words) {
+        const auto& term = terms.at(word);
+        if (term.first != nullptr) {
+            AddMinusPostings(result, *term.first, status);
+        }
+    }
+    return result;
+}
+
+SearchServer::QueryPostings SearchServer::FindQueryPostings(const Query& query, const CollectionStatistics& statistics,
+    std::optional<DocumentStatus> status) const {
+    QueryPostings result;
+    const InverseDocumentFreq inverse_document_freq = PrepareScoring(result, statistics.document_count, statistics.word_count);
+    for (const string_view word : query.plus_words) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            AddPlusPostings(result, *postings, inverse_document_freq(statistics.document_freqs.at(word)), status);
+        }
+    }
+    for (const string_view word : query.minus_words) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            AddMinusPostings(result, *postings, status);
+        }
+    }
+    return result;
+}
+
+void SearchServer::AddPlusPostings(QueryPostings& query_postings, const StatusPostings& postings,
+    double inverse_document_freq, std::optional<DocumentStatus> status) {
+    // слова добавляются по одному, номер слова - число уже добавленных
+    const size_t word_index = query_postings.plus_word_indexes.empty() ? 0 : query_postings.plus_word_indexes.back() + 1;
+    postings.ForEachPart(status, [&](const PostingList& part) {
+        query_postings.plus_postings.emplace_back(&part, inverse_document_freq);
+        query_postings.plus_word_indexes.push_back(word_index);
+        });
+}
+
+void SearchServer::AddMinusPostings(QueryPostings& query_postings, const StatusPostings& postings,
+    std::optional<DocumentStatus> status) {
+    postings.ForEachPart(status, [&](const PostingList& part) {
+        query_postings.minus_postings.push_back(&part);
+        });
 }
 
 const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
 
     static map<string_view, double>nullmap{};
 
-    if (word_freqs.count(document_id) == 1) {
-        return word_freqs.at(document_id);
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal != NO_ORDINAL) {
+        // словарь собирается из id слов документа при первом обращении
+        return word_freqs_.Get(ordinal, [this, ordinal]() {
+            map<string_view, double> freqs;
+            for (const auto [term_id, term_freq] : GetDocumentTerms(ordinal)) {
+                freqs.emplace(word_to_document_freqs_.GetTerm(term_id), term_freq);
+            }
+            return freqs;
+            });
     }
     else
         return nullmap;
 }
 
+vector<string_view> SearchServer::GetDocumentWords(int document_id) const {
+    const auto terms = GetDocumentTerms(GetOrdinal(document_id));
+    vector<string_view> words;
+    words.reserve(terms.size());
+    for (const auto [term_id, term_freq] : terms) {
+        words.push_back(word_to_document_freqs_.GetTerm(term_id));
+    }
+    return words;
+}
+
+void SearchServer::SetKeepDocumentTexts(bool keep) {
+    keep_document_texts_ = keep;
+}
+
+string_view SearchServer::GetDocumentText(int document_id) const {
+    const int ordinal = GetOrdinal(document_id);
+    return document_texts_[ordinal] ? string_view(*document_texts_[ordinal]) : string_view();
+}
+
+void SearchServer::SaveIndex(const string& path) const {
+    if (!removed_ordinals_->empty()) {
+        // копия разделяет с сервером все данные, кроме очищаемых списков
+        SearchServer purged(*this);
+        purged.PurgeRemovedDocuments();
+        purged.SaveIndex(path);
+        return;
+    }
+    // документы по возрастанию id получают номера 0, 1, ...,
+    // живые слова по алфавиту получают id 0, 1, ...
+    const set<int>& document_ids = GetDocumentIds();
+    vector<int> new_ordinals(ordinal_to_document_id_.size(), NO_ORDINAL);
+    int next_ordinal = 0;
+    for (const int document_id : document_ids) {
+        new_ordinals[FindOrdinal(document_id)] = next_ordinal++;
+    }
+
+    IndexSegmentWriter::Sizes sizes;
+    vector<pair<string_view, uint32_t>> terms;
+    uint32_t term_id_bound = 0;
+    word_to_document_freqs_.ForEachTerm([&](uint32_t term_id, string_view term, const StatusPostings& postings) {
+        terms.emplace_back(term, term_id);
+        term_id_bound = std::max(term_id_bound, term_id + 1);
+        sizes.term_chars += term.size();
+        sizes.posting_count += postings.Size();
+        sizes.posting_block_count += IndexSegment::GetPostingBlockCount(postings.Size());
+        });
+    std::sort(terms.begin(), terms.end());
+    vector<uint32_t> new_term_ids(term_id_bound, InvertedIndex::NO_TERM);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        new_term_ids[terms[i].second] = static_cast<uint32_t>(i);
+    }
+
+    for (const string& stop_word : *stop_words_) {
+        sizes.stop_word_chars += stop_word.size();
+    }
+    sizes.stop_word_count = stop_words_->Size();
+    sizes.document_count = document_ids.size();
+    sizes.word_count = static_cast<uint64_t>(total_word_count_);
+    for (const int document_id : document_ids) {
+        sizes.document_term_count += GetDocumentTerms(FindOrdinal(document_id)).size();
+    }
+    sizes.term_count = terms.size();
+
+    IndexSegmentWriter writer(path, sizes);
+    for (const string& stop_word : *stop_words_) {
+        writer.WriteStopWord(stop_word);
+    }
+    vector<TermFrequency> document_terms;
+    for (const int document_id : document_ids) {
+        const int ordinal = FindOrdinal(document_id);
+        document_terms.clear();
+        for (const auto [term_id, term_freq] : GetDocumentTerms(ordinal)) {
+            document_terms.push_back({ new_term_ids[term_id], term_freq });
+        }
+        writer.WriteDocument(document_id, documents_[ordinal], document_terms);
+    }
+    vector<pair<int, double>> postings;
+    vector<int> posting_ids;
+    vector<double> posting_freqs;
+    for (const auto& [term, term_id] : terms) {
+        postings.clear();
+        word_to_document_freqs_.GetPostings(term_id).ForEach([&](int ordinal, double term_freq) {
+            postings.emplace_back(new_ordinals[ordinal], term_freq);
+            });
+        std::sort(postings.begin(), postings.end());
+        posting_ids.clear();
+        posting_freqs.clear();
+        for (const auto& [ordinal, term_freq] : postings) {
+            posting_ids.push_back(ordinal);
+            posting_freqs.push_back(term_freq);
+        }
+        writer.WriteTerm(term, posting_ids, posting_freqs);
+    }
+    writer.Finish();
+}
+
+SearchServer SearchServer::OpenIndex(const string& path) {
+    return SearchServer(std::make_shared<const IndexSegment>(path));
+}
+
+void SearchServer::CompactTerms() {
+    // собранные словари и выданные слова ссылаются на строки старой арены
+    retired_arenas_.push_back({ word_to_document_freqs_.GetArena(), arena_document_count_ });
+    ++arena_generation_;
+    arena_document_count_ = 0;
+    word_to_document_freqs_.Compact();
+    while (!retired_arenas_.empty() && retired_arenas_.front().document_count == 0) {
+        retired_arenas_.pop_front();
+    }
+}
+
 void SearchServer::RemoveDocument(int document_id)
 {
-    if (word_freqs.count(document_id) == 0) {
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal == NO_ORDINAL) {
         return;
     }
 
-    for (auto& [word, freq] : word_freqs.at(document_id)) {
+    const DocumentStatus status = documents_[ordinal].status;
+    for (auto& [term_id, freq] : GetDocumentTerms(ordinal)) {
 
-        word_to_document_freqs_.at(word).erase(document_id);
+        word_to_document_freqs_.Remove(term_id, ordinal, status);
     }
 
-    document_ids_.erase(document_id);
-    documents_.erase(document_id);
-    word_freqs.erase(document_id);
+    ReleaseOrdinal(document_id, ordinal);
 }
 
 void SearchServer::RemoveDocument(std::execution::sequenced_policy policy, int document_id)
 {
-    if (word_freqs.count(document_id) == 0) {
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal == NO_ORDINAL) {
         return;
     }
 
-    std::for_each(policy, word_freqs.at(document_id).begin(), word_freqs.at(document_id).end(), [&document_id, this](auto& wordAndData)
+    const auto terms = GetDocumentTerms(ordinal);
+    const DocumentStatus status = documents_[ordinal].status;
+    std::for_each(policy, terms.begin(), terms.end(), [&ordinal, status, this](auto& termAndData)
         {
-            word_to_document_freqs_.at(wordAndData.first).erase(document_id);
+            word_to_document_freqs_.Remove(termAndData.term_id, ordinal, status);
         });
 
-    document_ids_.erase(document_id);
-    documents_.erase(document_id);
-    word_freqs.erase(document_id);
+    ReleaseOrdinal(document_id, ordinal);
 }
 
 void SearchServer::RemoveDocument(std::execution::parallel_policy policy, int document_id)
 {
-    if (word_freqs.count(document_id) == 0) {
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal == NO_ORDINAL) {
         return;
     }
-    std::vector<std::string_view> vec(word_freqs.at(document_id).size());
-    std::transform(policy, word_freqs.at(document_id).begin(), word_freqs.at(document_id).end(), vec.begin(), [](auto& a)
+    // списки отделяются от копий индекса последовательно,
+    // параллельно меняются только сами списки
+    const auto terms = GetDocumentTerms(ordinal);
+    const DocumentStatus status = documents_[ordinal].status;
+    std::vector<StatusPostings*> vec;
+    vec.reserve(terms.size());
+    for (const auto& [term_id, freq] : terms) {
+        vec.push_back(&word_to_document_freqs_.GetMutablePostings(term_id));
+    }
+
+    std::for_each(policy, vec.begin(), vec.end(), [&ordinal, status](StatusPostings* postings)
         {
-            return a.first;
+            postings->Remove(ordinal, status);
         });
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (vec[i]->Empty()) {
+            word_to_document_freqs_.OnPostingsEmptied(terms[i].term_id);
+        }
+    }
 
-    std::for_each(policy, vec.begin(), vec.end(), [&document_id, this](auto& word)
-        {
-            word_to_document_freqs_.at(word).erase(document_id);
+    ReleaseOrdinal(document_id, ordinal);
+}
+
+void SearchServer::RemoveDocuments(const vector<int>& document_ids) {
+    for (const int document_id : document_ids) {
+        const int ordinal = FindOrdinal(document_id);
+        if (ordinal == NO_ORDINAL) {
+            continue;
+        }
+        MarkRemoved(document_id, ordinal);
+        removed_ordinals_.Mutable().push_back(ordinal);
+    }
+    if (removed_ordinals_->size() > std::max(MIN_PURGE_DOCUMENTS, static_cast<size_t>(GetIndexedDocumentCount()) / 4)) {
+        PurgeRemovedDocuments();
+    }
+}
+
+void SearchServer::PurgeRemovedDocuments() {
+    if (removed_ordinals_->empty()) {
+        return;
+    }
+    // после очистки IDF и средняя длина считаются без удалённых документов
+    ++index_epoch_;
+    vector<int> ordinals = *removed_ordinals_;
+    std::sort(ordinals.begin(), ordinals.end());
+
+    // удаляемые вхождения по словам, в каждом слове по возрастанию номеров
+    vector<uint32_t> term_ids;
+    vector<vector<int>> term_ordinals;
+    unordered_map<uint32_t, size_t> term_indexes;
+    for (const int ordinal : ordinals) {
+        for (const auto [term_id, term_freq] : GetDocumentTerms(ordinal)) {
+            const auto [it, inserted] = term_indexes.emplace(term_id, term_ids.size());
+            if (inserted) {
+                term_ids.push_back(term_id);
+                term_ordinals.emplace_back();
+            }
+            term_ordinals[it->second].push_back(ordinal);
+        }
+    }
+
+    // списки отделяются от копий индекса последовательно, затем каждый
+    // список чистится в своём потоке: списки разных слов не пересекаются
+    vector<StatusPostings*> postings;
+    postings.reserve(term_ids.size());
+    for (const uint32_t term_id : term_ids) {
+        postings.push_back(&word_to_document_freqs_.GetMutablePostings(term_id));
+    }
+    vector<size_t> indexes(term_ids.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        postings[index]->RemoveSorted(term_ordinals[index]);
+        });
+
+    bool has_empty_terms = false;
+    for (size_t i = 0; i < term_ids.size(); ++i) {
+        if (postings[i]->Empty()) {
+            word_to_document_freqs_.OnPostingsEmptied(term_ids[i]);
+            has_empty_terms = true;
+        }
+    }
+    for (const int ordinal : ordinals) {
+        FreeOrdinal(ordinal);
+    }
+    removed_ordinals_.Mutable().clear();
+    if (has_empty_terms) {
+        CompactTerms();
+    }
+}
+
+void SearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    const int ordinal = GetOrdinal(document_id);
+    DocumentData document_data = documents_[ordinal];
+    if (document_data.status == status) {
+        return;
+    }
+    // частота вхождения хранится и в словах документа, текст не нужен
+    for (const auto [term_id, term_freq] : GetDocumentTerms(ordinal)) {
+        word_to_document_freqs_.GetMutablePostings(term_id).Move(ordinal, term_freq, document_data.status, status);
+    }
+    document_data.status = status;
+    SetDocumentData(ordinal, document_data);
+    ++index_epoch_;
+}
+
+set<int>& SearchServer::GetDocumentIds() const {
+    return document_ids_.Get([this]() {
+        set<int> ids;
+        for (size_t ordinal = 0; ordinal < ordinal_to_document_id_.size(); ++ordinal) {
+            if (ordinal_to_document_id_[ordinal] != NO_ORDINAL) {
+                ids.insert(ordinal_to_document_id_[ordinal]);
+            }
+        }
+        return ids;
+        });
+}
+
+int SearchServer::FindOrdinal(int document_id) const {
+    if (const int* ordinal = document_to_ordinal_.Find(document_id)) {
+        return *ordinal;
+    }
+    if (!segment_) {
+        return NO_ORDINAL;
+    }
+    // номер удалённого документа сегмента мог перейти к другому документу
+    const int ordinal = segment_->FindDocument(document_id);
+    return ordinal >= 0 && ordinal_to_document_id_[ordinal] == document_id ? ordinal : NO_ORDINAL;
+}
+
+int SearchServer::GetOrdinal(int document_id) const {
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal == NO_ORDINAL) {
+        throw out_of_range("Document "s + to_string(document_id) + " not found"s);
+    }
+    return ordinal;
+}
+
+int SearchServer::AcquireOrdinal(int document_id) {
+    int ordinal;
+    if (!free_ordinals_.empty()) {
+        ordinal = free_ordinals_.back();
+        free_ordinals_.pop_back();
+        ordinal_to_document_id_.Mutable(ordinal) = document_id;
+        document_arena_generations_.Mutable(ordinal) = arena_generation_;
+    }
+    else {
+        ordinal = static_cast<int>(ordinal_to_document_id_.size());
+        ordinal_to_document_id_.push_back(document_id);
+        documents_.push_back({});
+        document_statuses_.push_back(NO_DOCUMENT_STATUS);
+        document_ratings_.push_back(0);
+        document_length_norms_.push_back(0.0);
+        document_texts_.push_back(nullptr);
+        document_terms_.push_back(nullptr);
+        document_arena_generations_.push_back(arena_generation_);
+    }
+    ++arena_document_count_;
+    document_to_ordinal_.Emplace(document_id, ordinal);
+    ++document_count_;
+    ++index_epoch_;
+    return ordinal;
+}
+
+void SearchServer::SetDocumentData(int ordinal, const DocumentData& document_data) {
+    documents_.Mutable(ordinal) = document_data;
+    document_statuses_.Mutable(ordinal) = static_cast<uint8_t>(document_data.status);
+    document_ratings_.Mutable(ordinal) = document_data.rating;
+    document_length_norms_.Mutable(ordinal) = Bm25Scorer::GetLengthNorm(bm25_params_, document_data.word_count);
+}
+
+ArrayView<SearchServer::TermFrequency> SearchServer::GetDocumentTerms(int ordinal) const {
+    const auto& terms = document_terms_[ordinal];
+    if (terms) {
+        return { terms->data(), terms->size() };
+    }
+    return segment_->GetDocumentTerms(ordinal);
+}
+
+void SearchServer::MarkRemoved(int document_id, int ordinal) {
+    document_ids_.Update([document_id](set<int>& ids) {
+        ids.erase(document_id);
         });
+    document_to_ordinal_.Erase(document_id);
+    --document_count_;
+    ++index_epoch_;
+    ordinal_to_document_id_.Mutable(ordinal) = NO_ORDINAL;
+    document_statuses_.Mutable(ordinal) = NO_DOCUMENT_STATUS;
+    if (document_texts_[ordinal]) {
+        document_texts_.Mutable(ordinal) = nullptr;
+    }
+    word_freqs_.Erase(ordinal);
+    ReleaseArenaGeneration(document_arena_generations_[ordinal]);
+}
+
+void SearchServer::FreeOrdinal(int ordinal) {
+    total_word_count_ -= documents_[ordinal].word_count;
+    document_terms_.Mutable(ordinal) = nullptr;
+    free_ordinals_.push_back(ordinal);
+}
+
+void SearchServer::ReleaseOrdinal(int document_id, int ordinal) {
+    MarkRemoved(document_id, ordinal);
+    FreeOrdinal(ordinal);
+
+    if (word_to_document_freqs_.NeedsCompaction()) {
+        CompactTerms();
+    }
+}
+
+void SearchServer::ReleaseArenaGeneration(uint32_t generation) {
+    if (generation == 0) {
+        return;
+    }
+    if (generation == arena_generation_) {
+        --arena_document_count_;
+        return;
+    }
+    // старая арена освобождается, когда удалены документы её и всех более
+    // ранних поколений: они могли получить слова и из неё
+    --retired_arenas_[generation - (arena_generation_ - retired_arenas_.size())].document_count;
+    while (!retired_arenas_.empty() && retired_arenas_.front().document_count == 0) {
+        retired_arenas_.pop_front();
+    }
+}
+
+void SearchServer::FillFilterMask(const StatusFilter& filter, int first, int last, vector<uint8_t>& mask) const {
+    mask.resize(last - first);
+    document_statuses_.ForEachSpan(first, last, [&](size_t index, const uint8_t* statuses, size_t count) {
+        FillStatusMask(statuses, count, filter.status, mask.data() + (index - first));
+        });
+}
+
+void SearchServer::FillFilterMask(const RatingFilter& filter, int first, int last, vector<uint8_t>& mask) const {
+    mask.resize(last - first);
+    // блоки обоих столбцов одного размера, поэтому участки совпадают
+    document_statuses_.ForEachSpan(first, last, [&](size_t index, const uint8_t* statuses, size_t count) {
+        document_ratings_.ForEachSpan(index, index + count, [&](size_t, const int* ratings, size_t) {
+            FillRatingMask(statuses, ratings, count, filter.min_rating, filter.max_rating, mask.data() + (index - first));
+            });
+        });
+}
+
+void SearchServer::FillFilterMask(const DocumentIdFilter& filter, int first, int last, vector<uint8_t>& mask) const {
+    mask.assign(last - first, 0);
+    for (const int document_id : filter.GetDocumentIds()) {
+        const int ordinal = FindOrdinal(document_id);
+        if (first <= ordinal && ordinal < last) {
+            mask[ordinal - first] = 0xFF;
+        }
+    }
+}
 
-    document_ids_.erase(document_id);
-    documents_.erase(document_id);
-    word_freqs.erase(document_id);
+int SearchServer::GetIndexedDocumentCount() const {
+    return document_count_ + static_cast<int>(removed_ordinals_->size());
 }
@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <execution>
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <string_view>
 #include <cmath>
 #include <vector>
@@ -10,16 +13,48 @@
 #include <deque>
 #include <thread>
 #include <functional>
+#include <exception>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include "document.h"
 #include "read_input_functions.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
+#include "copy_on_write.h"
+#include "document_filter.h"
+#include "index_segment.h"
+#include "inverted_index.h"
+#include "query_stats.h"
+#include "ranking.h"
+#include "score_accumulator.h"
+#include "stop_word_set.h"
+#include "top_documents.h"
 
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
-const double VALUE = 1e-6;
 const unsigned int NUMTHREAD = std::thread::hardware_concurrency();
 
+// Как искать лучшие документы запроса. Результат не зависит от способа.
+// EXHAUSTIVE оценивает каждый документ со словами запроса.
+// WAND обходит списки вхождений одновременно и пропускает документы,
+// у которых сумма наибольших вкладов их слов не проходит в текущую
+// выдачу. BLOCK_MAX_WAND дополнительно сверяет наибольшие вклады
+// в блоках списков и пропускает блоки целиком. Отсечение выгодно
+// для запросов из нескольких слов с длинными списками и малым max_count.
+enum class RetrievalStrategy {
+    EXHAUSTIVE,
+    WAND,
+    BLOCK_MAX_WAND,
+};
+
+// документ для пакетной загрузки
+struct DocumentToAdd {
+    int id = 0;
+    string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    vector<int> ratings;
+};
+
 class SearchServer {
 public:
     template <typename StringContainer>
@@ -32,22 +67,91 @@ public:
     void AddDocument(int document_id, string_view document, DocumentStatus status,
         const vector<int>& ratings);
 
+    // Пакетная загрузка. Документы разбиваются на части, каждая часть
+    // разбирается в своём потоке в частичный индекс, затем частичные индексы
+    // сливаются с основным за один проход, списки вхождений заполняются
+    // параллельно. Результат совпадает с последовательными вызовами
+    // AddDocument, включая id слов и порядковые номера документов.
+    // При ошибке в любом документе пакета сервер не меняется.
+    void AddDocuments(const vector<DocumentToAdd>& documents);
+    // то же для потока документов, который загружается пакетами
+    template <typename InputIt>
+    void AddDocuments(InputIt first, InputIt last);
+
+    // max_count - сколько лучших документов вернуть;
+    // в stats, если он задан, записывается статистика запроса.
+    // Фильтры из document_filter.h проверяются по столбцам статусов
+    // и рейтингов без вызова предиката на каждое вхождение.
     template <typename DocumentPredicate, typename Policy>
-    std::vector<Document> FindTopDocuments(Policy&& policy, string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(Policy&& policy, string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT, RetrievalStrategy strategy = RetrievalStrategy::EXHAUSTIVE,
+        QueryStats* stats = nullptr) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT, RetrievalStrategy strategy = RetrievalStrategy::EXHAUSTIVE,
+        QueryStats* stats = nullptr) const;
 
     template <typename Policy>
-    std::vector<Document> FindTopDocuments(Policy&& policy, string_view raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(Policy&& policy, string_view raw_query, DocumentStatus status,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT, RetrievalStrategy strategy = RetrievalStrategy::EXHAUSTIVE,
+        QueryStats* stats = nullptr) const;
+    std::vector<Document> FindTopDocuments(string_view raw_query, DocumentStatus status,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT, RetrievalStrategy strategy = RetrievalStrategy::EXHAUSTIVE,
+        QueryStats* stats = nullptr) const;
 
     template <typename Policy>
     std::vector<Document> FindTopDocuments(Policy&& policy, string_view raw_query) const;
     std::vector<Document> FindTopDocuments(string_view raw_query) const;
 
+    // Все документы запроса с релевантностью без упорядочивания и без
+    // ограничения числа, для постраничного просмотра (см. SearchResultCursor)
+    template <typename DocumentPredicate>
+    vector<Document> FindMatchedDocuments(string_view raw_query, DocumentPredicate document_predicate) const;
+
+    // Пакетный поиск. Одинаковые запросы выполняются один раз, слова всех
+    // запросов ищутся в индексе и получают IDF один раз на пакет, сами
+    // запросы распределяются по потокам планировщиком с перехватом задач.
+    // consumer(query_index, documents) вызывается из рабочих потоков
+    // для каждого запроса пакета, в том числе для повторов.
+    template <typename QueryContainer, typename DocumentPredicate, typename Consumer>
+    void FindTopDocumentsBatch(const QueryContainer& raw_queries, DocumentPredicate document_predicate, Consumer consumer,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Поиск по нескольким серверам с общей статистикой (см. ShardedSearchServer).
+    // AddStatistics прибавляет к statistics число документов и слов сервера
+    // и число его документов с каждым плюс-словом запроса.
+    // FindTopDocumentsWithStatistics оценивает документы по переданной
+    // статистике, а не по своей. Ключи document_freqs - слова из raw_query.
+    struct CollectionStatistics {
+        int document_count = 0;
+        int64_t word_count = 0;
+        unordered_map<string_view, int> document_freqs;
+    };
+    void AddStatistics(string_view raw_query, CollectionStatistics& statistics) const;
+    template <typename DocumentPredicate>
+    vector<Document> FindTopDocumentsWithStatistics(string_view raw_query, const CollectionStatistics& statistics,
+        DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Оценка релевантности, по умолчанию TF-IDF. Всё, что зависит от числа
+    // документов и средней длины документа, считается один раз на запрос,
+    // поправки BM25 на длину хранятся у документов и пересчитываются
+    // при смене параметров.
+    void SetRankingModel(RankingModel model, const Bm25Params& params = {});
+    RankingModel GetRankingModel() const;
+
     int GetDocumentCount() const;
 
+    // Растёт при каждом изменении, от которого зависит выдача: добавлении,
+    // удалении и очистке документов, смене статуса и модели оценки. Равные значения
+    // у одного сервера означают одинаковую выдачу на любой запрос.
+    uint64_t GetIndexEpoch() const;
+
+    // Гистограммы всех запросов FindTopDocuments с начала работы или
+    // с последней очистки. Копии сервера пишут в общие гистограммы.
+    const QueryHistograms& GetQueryHistograms() const;
+    void ClearQueryHistograms();
+
     set<int>::const_iterator begin() const;
     set<int>::const_iterator end() const;
     set<int>::iterator begin();
@@ -56,32 +160,163 @@ public:
     tuple<vector<string_view>, DocumentStatus> MatchDocument(string_view raw_query, int document_id) const;
     tuple<vector<string_view>, DocumentStatus> MatchDocument(std::execution::sequenced_policy ex, string_view raw_query, int document_id) const;
     tuple<vector<string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy ex, string_view raw_query, int document_id) const;
+    // MatchDocument для многих документов: запрос разбирается один раз,
+    // каждый список вхождений проходится один раз по возрастанию номеров
+    // документов. Результаты идут в порядке document_ids.
+    vector<tuple<vector<string_view>, DocumentStatus>> MatchDocuments(string_view raw_query, const vector<int>& document_ids) const;
     const map<string_view, double>& GetWordFrequencies(int document_id) const;
+    // различные слова документа без частот; в отличие от
+    // GetWordFrequencies ничего не кеширует. Бросает out_of_range для
+    // неизвестного id, строки действительны до изменения сервера
+    vector<string_view> GetDocumentWords(int document_id) const;
     void RemoveDocument(int document_id);
     void RemoveDocument(std::execution::parallel_policy policy, int document_id);
     void RemoveDocument(std::execution::sequenced_policy policy, int document_id);
+    // Пакетное удаление. Документы сразу перестают находиться по id и при
+    // поиске, но их вхождения остаются в списках до очистки: поиск
+    // пропускает такие документы, а IDF и средняя длина документа до очистки
+    // считаются с их учётом. Неизвестные id пропускаются. Очистка
+    // запускается сама, когда удалённых документов становится много.
+    void RemoveDocuments(const vector<int>& document_ids);
+    // Убирает из индекса вхождения документов, удалённых RemoveDocuments:
+    // списки слов чистятся параллельно, каждый за один проход, слова
+    // без вхождений освобождаются.
+    void PurgeRemovedDocuments();
+
+    // Меняет статус документа. Вхождения документа переносятся в части
+    // списков его нового статуса без повторной индексации текста.
+    // Бросает out_of_range для неизвестного id.
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    // Исходный текст документа после индексации не нужен и по умолчанию
+    // не хранится. При включённом хранении GetDocumentText возвращает
+    // текст документов, добавленных после включения, иначе пустую строку.
+    void SetKeepDocumentTexts(bool keep);
+    string_view GetDocumentText(int document_id) const;
+
+    // Сохраняет индекс в файл. Открытый через OpenIndex сервер готов
+    // к поиску после одного проверочного прохода по файлу: данные не
+    // разбираются и не копируются, а читаются из отображения, новые
+    // документы и удаления хранятся в памяти поверх сохранённых данных.
+    // Тексты документов и настройки сервера не сохраняются.
+    void SaveIndex(const string& path) const;
+    static SearchServer OpenIndex(const string& path);
+
+    // Переносит слова в новую арену и освобождает слова, оставшиеся без
+    // документов. Вызывается автоматически, когда таких слов становится много.
+    // Слова, выданные до уплотнения (GetWordFrequencies, MatchDocument,
+    // GetDocumentWords), остаются действительными до удаления их документа.
+    void CompactTerms();
 
     bool IsStopWord(const string_view word) const;
+    bool HasDocument(int document_id) const;
 
-private:
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-        string word_;
+    // разобранный запрос: слова без стоп-слов, отсортированные и без повторов
+    struct Query {
+        vector<string_view> plus_words;
+        vector<string_view> minus_words;
     };
-    
-   
-    std::set<std::string, std::less<>> stop_words_;
-    map<string_view, map<int, double>> word_to_document_freqs_;
-    map<int, DocumentData> documents_;
-    set<int> document_ids_;
-    map<int, map<string_view, double>>word_freqs;
 
+    Query NormalizeQuery(string_view raw_query) const;
 
+private:
+    using DocumentData = IndexSegment::DocumentData;
+    // слова документа хранятся как id из словаря индекса
+    using TermFrequency = IndexSegment::TermFrequency;
+
+    static constexpr int NO_ORDINAL = -1;
+    static constexpr size_t BULK_BATCH_SIZE = 1 << 16;
+    static constexpr size_t MIN_PURGE_DOCUMENTS = 1024;
+    // запас к наибольшим вкладам слов, чтобы ошибки округления при сложении
+    // вкладов не отсекли документ, проходящий в выдачу
+    static constexpr double PRUNING_BOUND_MARGIN = 1.0 + 1e-9;
+    // маска фильтра строится по диапазону, если в нём не больше
+    // FILTER_MASK_RANGE_PER_POSTING документов на вхождение плюс-слов,
+    // иначе каждый документ проверяется по столбцам отдельно
+    static constexpr size_t FILTER_MASK_RANGE_PER_POSTING = 8;
+
+    explicit SearchServer(std::shared_ptr<const IndexSegment> segment);
+   
+    // Все поля копируются при записи: копия сервера разделяет с оригиналом
+    // данные, пока одна из копий их не изменит.
+    CowPtr<StopWordSet> stop_words_;
+    InvertedIndex word_to_document_freqs_;
+    // множество id для обхода сервера строится по требованию
+    LazyValue<set<int>> document_ids_;
+
+    // сохранённый индекс, поверх которого работает сервер, или nullptr;
+    // его документы занимают первые порядковые номера
+    std::shared_ptr<const IndexSegment> segment_;
+
+    // документам выдаются плотные внутренние порядковые номера,
+    // номера удалённых документов переиспользуются;
+    // документы сегмента ищутся в самом сегменте
+    CowHashMap<int, int> document_to_ordinal_;
+    int document_count_ = 0;
+    uint64_t index_epoch_ = 0;
+    // сумма word_count всех документов, для средней длины в BM25
+    int64_t total_word_count_ = 0;
+    CowVector<int> ordinal_to_document_id_;
+    CowVector<int> free_ordinals_;
+    // номера документов, удалённых RemoveDocuments, чьи вхождения ещё
+    // в индексе; номера освобождаются при очистке
+    CowPtr<vector<int>> removed_ordinals_;
+
+    // данные документов по порядковому номеру
+    CowVector<DocumentData> documents_;
+    // статусы и рейтинги из documents_ плотными столбцами для фильтров;
+    // у номеров без документа статус NO_DOCUMENT_STATUS
+    CowVector<uint8_t> document_statuses_;
+    CowVector<int> document_ratings_;
+    // поправки BM25 на длину документов при bm25_params_ (Bm25Scorer::GetLengthNorm)
+    CowVector<double> document_length_norms_;
+    // для документов сегмента nullptr, их слова читаются из сегмента
+    CowVector<shared_ptr<const vector<TermFrequency>>> document_terms_;
+    // исходные тексты, если включено их хранение
+    CowVector<shared_ptr<const string>> document_texts_;
+    bool keep_document_texts_ = false;
+    RankingModel ranking_model_ = RankingModel::TF_IDF;
+    Bm25Params bm25_params_;
+    // словари для GetWordFrequencies, собираются по требованию
+    LazyMap<int, map<string_view, double>> word_freqs_;
+    // Арена, заменённая уплотнением, хранится, пока живы документы,
+    // добавленные до замены: их слова могли быть выданы из этой арены.
+    // Поколение 0 у документов сегмента, их слова лежат в сегменте.
+    struct RetiredArena {
+        std::shared_ptr<const TermArena> arena;
+        // живые документы, добавленные при этой арене
+        int document_count;
+    };
+    uint32_t arena_generation_ = 1;
+    int arena_document_count_ = 0;
+    // поколения arena_generation_ - size, ..., arena_generation_ - 1
+    std::deque<RetiredArena> retired_arenas_;
+    // поколение арены, при котором добавлен документ
+    CowVector<uint32_t> document_arena_generations_;
+    std::shared_ptr<QueryHistograms> query_histograms_ = std::make_shared<QueryHistograms>();
+
+
+
+    set<int>& GetDocumentIds() const;
+    int FindOrdinal(int document_id) const;
+    // как FindOrdinal, но бросает out_of_range для неизвестного id
+    int GetOrdinal(int document_id) const;
+    int AcquireOrdinal(int document_id);
+    void SetDocumentData(int ordinal, const DocumentData& document_data);
+    ArrayView<TermFrequency> GetDocumentTerms(int ordinal) const;
+    // документ перестаёт находиться по id, его вхождения остаются
+    void MarkRemoved(int document_id, int ordinal);
+    // вхождения документа уже убраны из индекса
+    void FreeOrdinal(int ordinal);
+    void ReleaseOrdinal(int document_id, int ordinal);
+    void ReleaseArenaGeneration(uint32_t generation);
+    // документы, чьи вхождения есть в индексе, для статистики коллекции
+    int GetIndexedDocumentCount() const;
 
     static bool IsValidWord(const string_view word);
 
-    vector<string_view> SplitIntoWordsNoStop(const string_view text) const;
+    // слова text без стоп-слов в буфер words
+    void SplitIntoWordsNoStop(const string_view text, vector<string_view>& words) const;
 
     static int ComputeAverageRating(const vector<int>& ratings);
 
@@ -93,70 +328,131 @@ private:
 
     QueryWord ParseQueryWord(string_view text) const;
 
-    struct Query {
-        vector<string_view> plus_words;
-        vector<string_view> minus_words;
+    Query ParseQuery(string_view text, bool flag = true) const;
+
+    // Списки вхождений слов запроса; для плюс-слов вместе с их IDF.
+    // От слова берутся части списка по статусам (см. StatusPostings),
+    // где могут быть документы нужного статуса, у каждой части свой элемент.
+    struct QueryPostings {
+        vector<pair<const PostingList*, double>> plus_postings;
+        // номер плюс-слова для каждого элемента plus_postings
+        vector<size_t> plus_word_indexes;
+        vector<const PostingList*> minus_postings;
+        // задан, если релевантность считается по BM25
+        std::optional<Bm25Scorer> bm25;
     };
 
-    Query ParseQuery(string_view text, bool flag = true) const;
+    // настраивает оценку запроса по статистике коллекции и возвращает IDF
+    InverseDocumentFreq PrepareScoring(QueryPostings& query_postings, int document_count, int64_t word_count) const;
+
+    // status - статус, которым ограничен поиск, если он известен
+    QueryPostings FindQueryPostings(const Query& query, std::optional<DocumentStatus> status) const;
+
+    // списки вхождений и IDF слов, собранные заранее для пакета запросов
+    using TermPostingsCache = unordered_map<string_view, pair<const StatusPostings*, double>>;
+
+    QueryPostings FindQueryPostings(const Query& query, const TermPostingsCache& terms,
+        std::optional<DocumentStatus> status) const;
+    QueryPostings FindQueryPostings(const Query& query, const CollectionStatistics& statistics,
+        std::optional<DocumentStatus> status) const;
+
+    // добавляют в query_postings части списка слова для статуса status
+    static void AddPlusPostings(QueryPostings& query_postings, const StatusPostings& postings,
+        double inverse_document_freq, std::optional<DocumentStatus> status);
+    static void AddMinusPostings(QueryPostings& query_postings, const StatusPostings& postings,
+        std::optional<DocumentStatus> status);
+
+    // проходит ли документ с номером ordinal предикат; номера без
+    // документа не проходят
+    template <typename DocumentPredicate>
+    bool IsAdmitted(DocumentPredicate& document_predicate, int ordinal) const;
+
+    // маска фильтра для номеров [first, last), см. FillStatusMask
+    void FillFilterMask(const StatusFilter& filter, int first, int last, vector<uint8_t>& mask) const;
+    void FillFilterMask(const RatingFilter& filter, int first, int last, vector<uint8_t>& mask) const;
+    void FillFilterMask(const DocumentIdFilter& filter, int first, int last, vector<uint8_t>& mask) const;
+
+    // приёмник всех найденных документов вместо кучи лучших
+    struct DocumentCollector {
+        vector<Document>& documents;
+
+        void Add(const Document& document) {
+            documents.push_back(document);
+        }
 
-    double ComputeWordInverseDocumentFreq(const string_view& word) const;
+        double GetEntryThreshold() const {
+            return -std::numeric_limits<double>::infinity();
+        }
+    };
+
+    // top_documents - TopDocuments или DocumentCollector;
+    // счётчики и время диапазона прибавляются к stats, если он задан
+    template<typename DocumentPredicate, typename Collector>
+    void FindDocumentsInRange(const QueryPostings& query_postings, int first, int last,
+        DocumentPredicate& document_predicate, Collector& top_documents,
+        RetrievalStrategy strategy = RetrievalStrategy::EXHAUSTIVE, QueryStats* stats = nullptr) const;
 
+    // WAND и BLOCK_MAX_WAND: документы оцениваются по возрастанию номеров,
+    // вклады слов складываются в том же порядке, что и при полном переборе
+    template<typename DocumentPredicate, typename Collector>
+    void FindDocumentsInRangePruned(const QueryPostings& query_postings, int first, int last,
+        DocumentPredicate& document_predicate, Collector& top_documents, bool use_block_max, QueryStats* stats) const;
 
     template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(string_view raw_query, DocumentPredicate document_predicate, size_t max_count,
+        RetrievalStrategy strategy, QueryStats* stats) const;
 
     template<typename DocumentPredicate>
-    vector<Document> FindAllDocuments(const execution::sequenced_policy& policy, string_view raw_query, DocumentPredicate document_predicate) const;
+    vector<Document> FindAllDocuments(const execution::sequenced_policy& policy, string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_count, RetrievalStrategy strategy, QueryStats* stats) const;
 
     template<typename DocumentPredicate>
-    vector<Document> FindAllDocuments(const execution::parallel_policy& policy, string_view raw_query, DocumentPredicate document_predicate) const;
+    vector<Document> FindAllDocuments(const execution::parallel_policy& policy, string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_count, RetrievalStrategy strategy, QueryStats* stats) const;
+
+    // добавляет статистику запроса в гистограммы и копирует её в stats
+    void RecordQueryStats(const QueryStats& query_stats, QueryStats* stats) const;
 
 };
 
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))  // Extract non-empty stop words
+    : stop_words_(StopWordSet(MakeUniqueNonEmptyStrings(stop_words)))  // Extract non-empty stop words
 {
-    if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
+    if (!all_of(stop_words_->begin(), stop_words_->end(), IsValidWord)) {
         throw invalid_argument("words are invalid"s);
     }
 }
 
-
-template <typename DocumentPredicate, typename Policy>
-vector<Document> SearchServer::FindTopDocuments(Policy&& policy, string_view raw_query, DocumentPredicate document_predicate) const {
-    auto matched_documents = FindAllDocuments(policy, raw_query, document_predicate);
-
-    std::sort(policy,
-        matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < VALUE) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
-
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename InputIt>
+void SearchServer::AddDocuments(InputIt first, InputIt last) {
+    vector<DocumentToAdd> batch;
+    while (first != last) {
+        batch.clear();
+        for (; first != last && batch.size() < BULK_BATCH_SIZE; ++first) {
+            batch.push_back(*first);
+        }
+        AddDocuments(batch);
     }
+}
 
-    return matched_documents;
+
+template <typename DocumentPredicate, typename Policy>
+vector<Document> SearchServer::FindTopDocuments(Policy&& policy, string_view raw_query, DocumentPredicate document_predicate,
+    size_t max_count, RetrievalStrategy strategy, QueryStats* stats) const {
+    return FindAllDocuments(policy, raw_query, document_predicate, max_count, strategy, stats);
 }
 
 template <typename DocumentPredicate>
-vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentPredicate document_predicate, size_t max_count,
+    RetrievalStrategy strategy, QueryStats* stats) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_count, strategy, stats);
 }
 
 template <typename Policy>
-vector<Document> SearchServer::FindTopDocuments(Policy&& policy, string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query,
-        [&status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+vector<Document> SearchServer::FindTopDocuments(Policy&& policy, string_view raw_query, DocumentStatus status, size_t max_count,
+    RetrievalStrategy strategy, QueryStats* stats) const {
+    return FindTopDocuments(policy, raw_query, StatusFilter{ status }, max_count, strategy, stats);
 }
 
 template <typename Policy>
@@ -164,109 +460,487 @@ vector<Document> SearchServer::FindTopDocuments(Policy&& policy, string_view raw
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template<typename DocumentPredicate>
-vector<Document> SearchServer::FindAllDocuments(string_view raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(raw_query);
-    std::map<int, double> document_to_relevance;
-
-    for (auto word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+template <typename QueryContainer, typename DocumentPredicate, typename Consumer>
+void SearchServer::FindTopDocumentsBatch(const QueryContainer& raw_queries, DocumentPredicate document_predicate, Consumer consumer,
+    size_t max_count) const {
+    static constexpr size_t NO_QUERY = std::numeric_limits<size_t>::max();
+    const size_t query_count = raw_queries.size();
+
+    // повторы запроса связываются в цепочку от первого вхождения
+    unordered_map<string_view, size_t> unique_indexes;
+    vector<size_t> unique_queries;
+    vector<size_t> last_duplicate;
+    vector<size_t> next_duplicate(query_count, NO_QUERY);
+    for (size_t i = 0; i < query_count; ++i) {
+        const auto [it, inserted] = unique_indexes.emplace(string_view(raw_queries[i]), unique_queries.size());
+        if (inserted) {
+            unique_queries.push_back(i);
+            last_duplicate.push_back(i);
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const DocumentData& documents_data = documents_.at(document_id);
-            if (document_predicate(document_id, documents_data.status, documents_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
-            }
+        else {
+            next_duplicate[last_duplicate[it->second]] = i;
+            last_duplicate[it->second] = i;
         }
     }
 
-    for (auto word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+    // исключения внутри параллельных алгоритмов приводят к terminate,
+    // поэтому ошибки разбора собираются и пробрасываются после
+    vector<Query> queries(unique_queries.size());
+    vector<exception_ptr> errors(unique_queries.size());
+    vector<size_t> indexes(unique_queries.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        try {
+            queries[index] = ParseQuery(raw_queries[unique_queries[index]]);
         }
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        catch (...) {
+            errors[index] = std::current_exception();
+        }
+        });
+    for (const exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
         }
     }
 
-    vector<Document> matched_documents;
-    for (auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    TermPostingsCache terms;
+    for (const Query& query : queries) {
+        for (const string_view word : query.plus_words) {
+            terms.emplace(word, pair<const StatusPostings*, double>{});
+        }
+        for (const string_view word : query.minus_words) {
+            terms.emplace(word, pair<const StatusPostings*, double>{});
+        }
+    }
+    const InverseDocumentFreq inverse_document_freq(ranking_model_, GetIndexedDocumentCount());
+    for (auto& [word, term] : terms) {
+        if (const StatusPostings* postings = word_to_document_freqs_.Find(word)) {
+            term = { postings, inverse_document_freq(static_cast<int>(postings->Size())) };
+        }
     }
-    return matched_documents;
+
+    const int ordinal_count = static_cast<int>(ordinal_to_document_id_.size());
+    const std::optional<DocumentStatus> status = GetFilteredStatus(document_predicate);
+    std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        TopDocuments top_documents(max_count);
+        FindDocumentsInRange(FindQueryPostings(queries[index], terms, status), 0, ordinal_count, document_predicate, top_documents);
+        const vector<Document> documents = top_documents.Extract();
+        for (size_t i = unique_queries[index]; i != NO_QUERY; i = next_duplicate[i]) {
+            consumer(i, documents);
+        }
+        });
+}
+
+template <typename DocumentPredicate>
+vector<Document> SearchServer::FindTopDocumentsWithStatistics(string_view raw_query, const CollectionStatistics& statistics,
+    DocumentPredicate document_predicate, size_t max_count) const {
+    const QueryPostings query_postings = FindQueryPostings(ParseQuery(raw_query), statistics,
+        GetFilteredStatus(document_predicate));
+
+    TopDocuments top_documents(max_count);
+    FindDocumentsInRange(query_postings, 0, static_cast<int>(ordinal_to_document_id_.size()), document_predicate, top_documents);
+    return top_documents.Extract();
+}
+
+template <typename DocumentPredicate>
+vector<Document> SearchServer::FindMatchedDocuments(string_view raw_query, DocumentPredicate document_predicate) const {
+    const QueryPostings query_postings = FindQueryPostings(ParseQuery(raw_query), GetFilteredStatus(document_predicate));
+
+    vector<Document> documents;
+    DocumentCollector collector{ documents };
+    FindDocumentsInRange(query_postings, 0, static_cast<int>(ordinal_to_document_id_.size()), document_predicate, collector);
+    return documents;
 }
 
 template<typename DocumentPredicate>
-vector<Document> SearchServer::FindAllDocuments(const execution::sequenced_policy& policy, string_view raw_query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    const auto query = ParseQuery(raw_query);
+vector<Document> SearchServer::FindAllDocuments(string_view raw_query, DocumentPredicate document_predicate, size_t max_count,
+    RetrievalStrategy strategy, QueryStats* stats) const {
+    return FindAllDocuments(std::execution::seq, raw_query, document_predicate, max_count, strategy, stats);
+}
+
+template<typename DocumentPredicate>
+vector<Document> SearchServer::FindAllDocuments(const execution::sequenced_policy&, string_view raw_query, DocumentPredicate document_predicate,
+    size_t max_count, RetrievalStrategy strategy, QueryStats* stats) const {
+    QueryStats query_stats;
+    StageTimer total_timer;
+    StageTimer timer;
+    const Query query = ParseQuery(raw_query);
+    timer.Lap(query_stats.parse_ns);
+    const QueryPostings query_postings = FindQueryPostings(query, GetFilteredStatus(document_predicate));
+    timer.Lap(query_stats.lookup_ns);
+
+    TopDocuments top_documents(max_count);
+    FindDocumentsInRange(query_postings, 0, static_cast<int>(ordinal_to_document_id_.size()), document_predicate, top_documents,
+        strategy, &query_stats);
+    timer.Restart();
+    vector<Document> result = top_documents.Extract();
+    timer.Lap(query_stats.selection_ns);
+    total_timer.Lap(query_stats.total_ns);
+    RecordQueryStats(query_stats, stats);
+    return result;
+}
+
+template<typename DocumentPredicate>
+vector<Document> SearchServer::FindAllDocuments(const execution::parallel_policy& policy, string_view raw_query, DocumentPredicate document_predicate,
+    size_t max_count, RetrievalStrategy strategy, QueryStats* stats) const {
+    QueryStats query_stats;
+    StageTimer total_timer;
+    StageTimer timer;
+    const Query query = ParseQuery(raw_query);
+    timer.Lap(query_stats.parse_ns);
+    const QueryPostings query_postings = FindQueryPostings(query, GetFilteredStatus(document_predicate));
+    timer.Lap(query_stats.lookup_ns);
+
+    // порядковые номера делятся на непересекающиеся диапазоны,
+    // у каждого диапазона свой накопитель и своя куча
+    const int ordinal_count = static_cast<int>(ordinal_to_document_id_.size());
+    const int range_count = static_cast<int>(std::max(1u, NUMTHREAD));
+    const int range_size = (ordinal_count + range_count - 1) / range_count;
+
+    std::vector<int> ranges(range_count);
+    std::iota(ranges.begin(), ranges.end(), 0);
+    std::vector<TopDocuments> range_tops(range_count, TopDocuments(max_count));
+    std::vector<QueryStats> range_stats(range_count);
+    std::for_each(policy, ranges.begin(), ranges.end(),
+        [&](int range) {
+            const int first = range * range_size;
+            const int last = std::min(ordinal_count, first + range_size);
+            if (first < last) {
+                FindDocumentsInRange(query_postings, first, last, document_predicate, range_tops[range], strategy,
+                    &range_stats[range]);
+            }
+        });
 
-    for (auto word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    timer.Restart();
+    TopDocuments top_documents(max_count);
+    for (int range = 0; range < range_count; ++range) {
+        top_documents.Merge(range_tops[range]);
+        query_stats += range_stats[range];
+    }
+    vector<Document> result = top_documents.Extract();
+    timer.Lap(query_stats.selection_ns);
+    total_timer.Lap(query_stats.total_ns);
+    RecordQueryStats(query_stats, stats);
+    return result;
+}
+
+template <typename DocumentPredicate>
+bool SearchServer::IsAdmitted(DocumentPredicate& document_predicate, int ordinal) const {
+    if constexpr (std::is_same_v<std::remove_cv_t<DocumentPredicate>, StatusFilter>) {
+        return document_statuses_[ordinal] == static_cast<uint8_t>(document_predicate.status);
+    }
+    else if constexpr (std::is_same_v<std::remove_cv_t<DocumentPredicate>, RatingFilter>) {
+        const int rating = document_ratings_[ordinal];
+        return document_statuses_[ordinal] != NO_DOCUMENT_STATUS
+            && document_predicate.min_rating <= rating && rating <= document_predicate.max_rating;
+    }
+    else if constexpr (std::is_same_v<std::remove_cv_t<DocumentPredicate>, DocumentIdFilter>) {
+        const int document_id = ordinal_to_document_id_[ordinal];
+        return document_id != NO_ORDINAL && document_predicate.Contains(document_id);
+    }
+    else {
+        const int document_id = ordinal_to_document_id_[ordinal];
+        if (document_id == NO_ORDINAL) {
+            return false;
+        }
+        const auto& document_data = documents_[ordinal];
+        return document_predicate(document_id, document_data.status, document_data.rating);
+    }
+}
+
+template<typename DocumentPredicate, typename Collector>
+void SearchServer::FindDocumentsInRange(const QueryPostings& query_postings, int first, int last,
+    DocumentPredicate& document_predicate, Collector& top_documents, RetrievalStrategy strategy, QueryStats* stats) const {
+    if (strategy != RetrievalStrategy::EXHAUSTIVE) {
+        FindDocumentsInRangePruned(query_postings, first, last, document_predicate, top_documents,
+            strategy == RetrievalStrategy::BLOCK_MAX_WAND, stats);
+        return;
+    }
+    // счётчики в регистрах, без статистики компилятор их убирает
+    uint64_t postings_scanned = 0;
+    uint64_t filtered_by_predicate = 0;
+    uint64_t filtered_by_minus_words = 0;
+    uint64_t candidates_sorted = 0;
+    StageTimer timer;
+    AccumulatorLease accumulator(last - first);
+
+    // Короткие списки минус-слов исключают документы заранее. Длинный
+    // список дешевле не обходить, а проверить по нему только найденных
+    // кандидатов, которых не больше суммы длин списков плюс-слов.
+    size_t candidate_bound = 0;
+    for (const auto& [postings, inverse_document_freq] : query_postings.plus_postings) {
+        candidate_bound += postings->Size();
+    }
+    // для фильтра из document_filter.h и длинных списков документы
+    // проверяются заранее по всему диапазону
+    bool use_filter_mask = false;
+    if constexpr (IS_DOCUMENT_FILTER<DocumentPredicate>) {
+        if (static_cast<size_t>(last - first) <= candidate_bound * FILTER_MASK_RANGE_PER_POSTING) {
+            FillFilterMask(document_predicate, first, last, accumulator->GetFilterMask());
+            use_filter_mask = true;
+        }
+    }
+    const uint8_t* const filter_mask = accumulator->GetFilterMask().data();
+
+    vector<const PostingList*> deferred_minus_postings;
+    for (const PostingList* postings : query_postings.minus_postings) {
+        if (postings->Size() > candidate_bound) {
+            deferred_minus_postings.push_back(postings);
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        postings->ForEachInRange(first, last, [&](int ordinal, double) {
+            ++postings_scanned;
+            ++filtered_by_minus_words;
+            accumulator->Exclude(ordinal - first);
+            });
+    }
+
+    // score(ordinal, term_freq) - вклад слова в релевантность документа
+    const auto add_postings = [&](const PostingList& postings, auto score) {
+        postings.ForEachInRange(first, last, [&](int ordinal, double term_freq) {
+            ++postings_scanned;
+            const size_t slot = ordinal - first;
+            if (!accumulator->IsTouched(slot)) {
+                if (use_filter_mask ? filter_mask[slot] == 0 : !IsAdmitted(document_predicate, ordinal)) {
+                    ++filtered_by_predicate;
+                    accumulator->Exclude(slot);
+                    return;
+                }
+            }
+            else if (accumulator->IsExcluded(slot)) {
+                return;
             }
+            accumulator->Add(slot, score(ordinal, term_freq));
+            });
+    };
+    for (const auto& [postings, inverse_document_freq] : query_postings.plus_postings) {
+        const double idf = inverse_document_freq;
+        if (query_postings.bm25) {
+            const Bm25Scorer& bm25 = *query_postings.bm25;
+            add_postings(*postings, [&, idf](int ordinal, double term_freq) {
+                return bm25(term_freq, document_length_norms_[ordinal], idf);
+                });
+        }
+        else {
+            add_postings(*postings, [idf](int, double term_freq) {
+                return term_freq * idf;
+                });
         }
     }
 
-    for (auto word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+    if (!deferred_minus_postings.empty()) {
+        vector<int> candidates;
+        accumulator->ForEach([&candidates, first](size_t slot, double) {
+            candidates.push_back(first + static_cast<int>(slot));
+            });
+        std::sort(candidates.begin(), candidates.end());
+        for (const PostingList* postings : deferred_minus_postings) {
+            PostingList::Seeker seeker(*postings);
+            for (const int ordinal : candidates) {
+                if (seeker.Contains(ordinal)) {
+                    ++filtered_by_minus_words;
+                    accumulator->Exclude(ordinal - first);
+                }
+            }
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+    }
+    if constexpr (QUERY_STATS_ENABLED) {
+        if (stats != nullptr) {
+            timer.Lap(stats->traversal_ns);
         }
     }
 
-    vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    accumulator->ForEach([&](size_t slot, double relevance) {
+        ++candidates_sorted;
+        const int ordinal = first + static_cast<int>(slot);
+        top_documents.Add({ ordinal_to_document_id_[ordinal], relevance, documents_[ordinal].rating });
+        });
+    if constexpr (QUERY_STATS_ENABLED) {
+        if (stats != nullptr) {
+            timer.Lap(stats->selection_ns);
+            stats->postings_scanned += postings_scanned;
+            // в полном переборе выдаче предлагается каждый оценённый документ
+            stats->documents_scored += candidates_sorted;
+            stats->filtered_by_predicate += filtered_by_predicate;
+            stats->filtered_by_minus_words += filtered_by_minus_words;
+            stats->candidates_sorted += candidates_sorted;
+        }
     }
-    return matched_documents;
 }
 
-template<typename DocumentPredicate>
-vector<Document> SearchServer::FindAllDocuments(const execution::parallel_policy& policy, string_view raw_query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(NUMTHREAD);
-    const auto query = ParseQuery(raw_query);
-
-    std::for_each(policy,
-        query.minus_words.begin(), query.minus_words.end(),
-        [this, &document_to_relevance](std::string_view word) {
-            if (word_to_document_freqs_.count(word)) {
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                    document_to_relevance.dell(document_id);
-                }
+template<typename DocumentPredicate, typename Collector>
+void SearchServer::FindDocumentsInRangePruned(const QueryPostings& query_postings, int first, int last,
+    DocumentPredicate& document_predicate, Collector& top_documents, bool use_block_max, QueryStats* stats) const {
+    static constexpr int END = PostingList::Cursor::END;
+    uint64_t postings_scanned = 0;
+    uint64_t documents_scored = 0;
+    uint64_t filtered_by_predicate = 0;
+    uint64_t filtered_by_minus_words = 0;
+    StageTimer timer;
+
+    // наибольший вклад слова с долей не больше term_freq
+    const auto get_bound = [&query_postings](double term_freq, double inverse_document_freq) {
+        const double bound = query_postings.bm25
+            ? query_postings.bm25->GetUpperBound(term_freq, inverse_document_freq)
+            : term_freq * inverse_document_freq;
+        return bound * PRUNING_BOUND_MARGIN;
+    };
+
+    // по каждому списку: курсор, его текущий документ (END за концом
+    // диапазона), наибольший вклад во всём списке и в текущем блоке
+    const size_t term_count = query_postings.plus_postings.size();
+    vector<PostingList::Cursor> cursors;
+    vector<int> documents(term_count);
+    vector<double> max_scores(term_count);
+    vector<int> block_last_ids(term_count, -1);
+    vector<double> block_max_scores(term_count);
+    cursors.reserve(term_count);
+    for (size_t term = 0; term < term_count; ++term) {
+        const auto& [postings, inverse_document_freq] = query_postings.plus_postings[term];
+        cursors.emplace_back(*postings, first);
+        max_scores[term] = get_bound(postings->GetMaxTermFreq(), inverse_document_freq);
+    }
+    // Документ есть только в одной части списка слова, поэтому при выборе
+    // опорного слова слово учитывается один раз с наибольшим вкладом своих
+    // частей. Сумма по блокам считается по частям и лишь завышается.
+    const vector<size_t>& word_indexes = query_postings.plus_word_indexes;
+    const size_t word_count = term_count == 0 ? 0 : *std::max_element(word_indexes.begin(), word_indexes.end()) + 1;
+    vector<double> word_max_scores(word_count, 0.0);
+    for (size_t term = 0; term < term_count; ++term) {
+        word_max_scores[word_indexes[term]] = std::max(word_max_scores[word_indexes[term]], max_scores[term]);
+    }
+    vector<int> word_marks(word_count, -1);
+    int mark = 0;
+    // вхождением считается каждая остановка курсора
+    const auto advance = [&](size_t term, int ordinal) {
+        ++postings_scanned;
+        cursors[term].Advance(ordinal);
+        const int document = cursors[term].GetDocumentId();
+        documents[term] = document < last ? document : END;
+    };
+    for (size_t term = 0; term < term_count; ++term) {
+        advance(term, first);
+    }
+    vector<PostingList::Seeker> minus_seekers;
+    minus_seekers.reserve(query_postings.minus_postings.size());
+    for (const PostingList* postings : query_postings.minus_postings) {
+        minus_seekers.emplace_back(*postings);
+    }
+
+    // слова по возрастанию текущего документа; слов в запросе немного
+    vector<size_t> order(term_count);
+    std::iota(order.begin(), order.end(), 0);
+    const auto sort_terms = [&order, &documents] {
+        for (size_t i = 1; i < order.size(); ++i) {
+            for (size_t j = i; j > 0 && documents[order[j]] < documents[order[j - 1]]; --j) {
+                std::swap(order[j], order[j - 1]);
             }
-        });
+        }
+    };
+    sort_terms();
+
+    while (true) {
+        const double threshold = top_documents.GetEntryThreshold();
+
+        // опорное слово - первое, на котором сумма наибольших вкладов
+        // превышает порог: документы до его документа в выдачу не пройдут
+        size_t pivot = term_count;
+        double bound_sum = 0.0;
+        ++mark;
+        for (size_t i = 0; i < term_count && documents[order[i]] != END; ++i) {
+            const size_t word = word_indexes[order[i]];
+            if (word_marks[word] != mark) {
+                word_marks[word] = mark;
+                bound_sum += word_max_scores[word];
+            }
+            if (bound_sum > threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == term_count) {
+            break;
+        }
+        const int pivot_ordinal = documents[order[pivot]];
+        while (pivot + 1 < term_count && documents[order[pivot + 1]] == pivot_ordinal) {
+            ++pivot;
+        }
 
-    for_each(policy,
-        query.plus_words.begin(), query.plus_words.end(),
-        [this, &document_predicate, &document_to_relevance](string_view word) {
-            if (word_to_document_freqs_.count(word)) {
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                    const auto& document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                        document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                    }
+        if (use_block_max) {
+            // документы от опорного до конца ближайшего блока оцениваются
+            // по наибольшим вкладам в блоках; блок слова запоминается, пока
+            // опорный документ не выйдет за его конец
+            double block_sum = 0.0;
+            int block_last = END;
+            for (size_t i = 0; i <= pivot; ++i) {
+                const size_t term = order[i];
+                if (block_last_ids[term] < pivot_ordinal) {
+                    PostingList::Cursor& cursor = cursors[term];
+                    cursor.ShallowAdvance(pivot_ordinal);
+                    block_last_ids[term] = cursor.GetBlockLastId();
+                    block_max_scores[term] = get_bound(cursor.GetBlockMaxFreq(), query_postings.plus_postings[term].second);
                 }
+                block_sum += block_max_scores[term];
+                block_last = std::min(block_last, block_last_ids[term]);
             }
-        });
+            if (block_sum <= threshold) {
+                int next_ordinal = block_last == END ? END : block_last + 1;
+                if (pivot + 1 < term_count) {
+                    next_ordinal = std::min(next_ordinal, documents[order[pivot + 1]]);
+                }
+                for (size_t i = 0; i <= pivot; ++i) {
+                    advance(order[i], next_ordinal);
+                }
+                sort_terms();
+                continue;
+            }
+        }
 
-    std::map<int, double> document_to_relevance_next = document_to_relevance.BuildOrdinaryMap();
-    std::vector<Document> matched_documents;
-    matched_documents.reserve(document_to_relevance_next.size());
+        if (documents[order[0]] != pivot_ordinal) {
+            // слова до опорного догоняют его документ
+            for (size_t i = 0; i < pivot && documents[order[i]] < pivot_ordinal; ++i) {
+                advance(order[i], pivot_ordinal);
+            }
+            sort_terms();
+            continue;
+        }
 
-    for (const auto [document_id, relevance] : document_to_relevance_next) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+        bool is_excluded = !IsAdmitted(document_predicate, pivot_ordinal);
+        filtered_by_predicate += is_excluded;
+        for (size_t i = 0; i < minus_seekers.size() && !is_excluded; ++i) {
+            is_excluded = minus_seekers[i].Contains(pivot_ordinal);
+            filtered_by_minus_words += is_excluded;
+        }
+        if (!is_excluded) {
+            ++documents_scored;
+            const auto& document_data = documents_[pivot_ordinal];
+            double relevance = 0.0;
+            for (size_t term = 0; term < term_count; ++term) {
+                if (documents[term] != pivot_ordinal) {
+                    continue;
+                }
+                const double term_freq = cursors[term].GetTermFreq();
+                const double inverse_document_freq = query_postings.plus_postings[term].second;
+                relevance += query_postings.bm25
+                    ? (*query_postings.bm25)(term_freq, document_length_norms_[pivot_ordinal], inverse_document_freq)
+                    : term_freq * inverse_document_freq;
+            }
+            top_documents.Add({ ordinal_to_document_id_[pivot_ordinal], relevance, document_data.rating });
+        }
+        for (size_t i = 0; i <= pivot; ++i) {
+            advance(order[i], pivot_ordinal + 1);
+        }
+        sort_terms();
+    }
+    if constexpr (QUERY_STATS_ENABLED) {
+        if (stats != nullptr) {
+            // выдача пополняется во время обхода, отдельного отбора нет
+            timer.Lap(stats->traversal_ns);
+            stats->postings_scanned += postings_scanned;
+            stats->documents_scored += documents_scored;
+            stats->filtered_by_predicate += filtered_by_predicate;
+            stats->filtered_by_minus_words += filtered_by_minus_words;
+            stats->candidates_sorted += documents_scored;
+        }
     }
-    return matched_documents;
 }
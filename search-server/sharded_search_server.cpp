@@ -0,0 +1,105 @@
+#include "sharded_search_server.h"
+
+void ShardedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+    const vector<int>& ratings) {
+    GetOwner(document_id).AddDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::AddDocuments(const vector<DocumentToAdd>& documents) {
+    vector<vector<DocumentToAdd>> shard_documents(shards_.size());
+    for (const DocumentToAdd& document : documents) {
+        shard_documents[GetShardIndex(document.id)].push_back(document);
+    }
+
+    vector<exception_ptr> errors(shards_.size());
+    vector<size_t> indexes(shards_.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        try {
+            shards_[index].AddDocuments(shard_documents[index]);
+        }
+        catch (...) {
+            errors[index] = std::current_exception();
+        }
+        });
+
+    const auto error = std::find_if(errors.begin(), errors.end(), [](const exception_ptr& error) {
+        return error != nullptr;
+        });
+    if (error == errors.end()) {
+        return;
+    }
+    // часть с ошибкой не изменилась, остальные откатываются
+    for (size_t index = 0; index < shards_.size(); ++index) {
+        if (!errors[index]) {
+            for (const DocumentToAdd& document : shard_documents[index]) {
+                shards_[index].RemoveDocument(document.id);
+            }
+        }
+    }
+    std::rethrow_exception(*error);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    GetOwner(document_id).RemoveDocument(document_id);
+}
+
+void ShardedSearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    GetOwner(document_id).SetDocumentStatus(document_id, status);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_count) const {
+    return FindTopDocuments(raw_query, StatusFilter{ status }, max_count);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+tuple<vector<string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    return GetOwner(document_id).MatchDocument(raw_query, document_id);
+}
+
+void ShardedSearchServer::SetRankingModel(RankingModel model, const Bm25Params& params) {
+    for (SearchServer& shard : shards_) {
+        shard.SetRankingModel(model, params);
+    }
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const SearchServer& shard : shards_) {
+        document_count += shard.GetDocumentCount();
+    }
+    return document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+const SearchServer& ShardedSearchServer::GetShard(size_t index) const {
+    return shards_.at(index);
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    // отрицательные id тоже попадают в какую-то часть, а она их отвергнет
+    return static_cast<size_t>(static_cast<unsigned int>(document_id)) % shards_.size();
+}
+
+SearchServer& ShardedSearchServer::GetOwner(int document_id) {
+    return shards_[GetShardIndex(document_id)];
+}
+
+const SearchServer& ShardedSearchServer::GetOwner(int document_id) const {
+    return shards_[GetShardIndex(document_id)];
+}
+
+SearchServer::CollectionStatistics ShardedSearchServer::CollectStatistics(string_view raw_query) const {
+    // статистика частей - несколько поисков в словаре на слово запроса
+    SearchServer::CollectionStatistics statistics;
+    for (const SearchServer& shard : shards_) {
+        shard.AddStatistics(raw_query, statistics);
+    }
+    return statistics;
+}
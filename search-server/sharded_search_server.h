@@ -0,0 +1,83 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include "search_server.h"
+#include "top_documents.h"
+
+// Индекс, разбитый на части (шарды) по остатку от деления id документа.
+// Добавление и удаление идут в часть, которой принадлежит документ, поиск -
+// во все части параллельно, лучшие документы частей сливаются в общую
+// выдачу. Статистика для оценки считается по всему индексу: части сначала
+// сообщают число своих документов и слов и во скольких документах есть
+// слова запроса, поэтому выдача совпадает с выдачей одного сервера со
+// всеми документами.
+class ShardedSearchServer {
+public:
+    template <typename StringContainer>
+    ShardedSearchServer(size_t shard_count, const StringContainer& stop_words);
+
+    void AddDocument(int document_id, string_view document, DocumentStatus status,
+        const vector<int>& ratings);
+    // пакет делится по частям, части загружаются параллельно;
+    // при ошибке загруженное из пакета удаляется
+    void AddDocuments(const vector<DocumentToAdd>& documents);
+    void RemoveDocument(int document_id);
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    template <typename DocumentPredicate>
+    vector<Document> FindTopDocuments(string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    vector<Document> FindTopDocuments(string_view raw_query, DocumentStatus status,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    vector<Document> FindTopDocuments(string_view raw_query) const;
+
+    tuple<vector<string_view>, DocumentStatus> MatchDocument(string_view raw_query, int document_id) const;
+
+    // задаёт оценку релевантности всем частям
+    void SetRankingModel(RankingModel model, const Bm25Params& params = {});
+
+    int GetDocumentCount() const;
+    size_t GetShardCount() const;
+    const SearchServer& GetShard(size_t index) const;
+
+private:
+    size_t GetShardIndex(int document_id) const;
+    SearchServer& GetOwner(int document_id);
+    const SearchServer& GetOwner(int document_id) const;
+    SearchServer::CollectionStatistics CollectStatistics(string_view raw_query) const;
+
+    vector<SearchServer> shards_;
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, const StringContainer& stop_words) {
+    if (shard_count == 0) {
+        throw invalid_argument("Shard count must be positive"s);
+    }
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.emplace_back(stop_words);
+    }
+}
+
+template <typename DocumentPredicate>
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query, DocumentPredicate document_predicate,
+    size_t max_count) const {
+    // ошибки разбора запроса вылетают здесь, до параллельной части
+    const SearchServer::CollectionStatistics statistics = CollectStatistics(raw_query);
+
+    vector<vector<Document>> shard_documents(shards_.size());
+    vector<size_t> indexes(shards_.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        shard_documents[index] = shards_[index].FindTopDocumentsWithStatistics(raw_query, statistics, document_predicate, max_count);
+        });
+
+    TopDocuments top_documents(max_count);
+    for (const vector<Document>& documents : shard_documents) {
+        for (const Document& document : documents) {
+            top_documents.Add(document);
+        }
+    }
+    return top_documents.Extract();
+}
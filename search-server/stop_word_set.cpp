@@ -0,0 +1,66 @@
+#include "stop_word_set.h"
+#include <algorithm>
+
+StopWordSet::StopWordSet(const std::set<std::string, std::less<>>& words)
+    : words_(words.begin(), words.end()) {
+    for (const std::string& word : words_) {
+        max_length_ = std::max(max_length_, word.size());
+    }
+
+    if (words_.empty()) {
+        return;
+    }
+    // заполнение не больше половины
+    size_t slot_count = 2;
+    while (slot_count < words_.size() * 2) {
+        slot_count *= 2;
+    }
+    slots_.resize(slot_count);
+    for (uint32_t word_index = 0; word_index < words_.size(); ++word_index) {
+        const uint32_t hash = Hash(words_[word_index]);
+        size_t slot = hash & (slot_count - 1);
+        while (slots_[slot].word_index != EMPTY) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots_[slot] = { hash, word_index };
+    }
+}
+
+bool StopWordSet::Contains(std::string_view word) const {
+    if (word.size() > max_length_ || slots_.empty()) {
+        return false;
+    }
+    const uint32_t hash = Hash(word);
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask; slots_[slot].word_index != EMPTY; slot = (slot + 1) & mask) {
+        if (slots_[slot].hash == hash && words_[slots_[slot].word_index] == word) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t StopWordSet::Size() const {
+    return words_.size();
+}
+
+bool StopWordSet::Empty() const {
+    return words_.empty();
+}
+
+std::vector<std::string>::const_iterator StopWordSet::begin() const {
+    return words_.begin();
+}
+
+std::vector<std::string>::const_iterator StopWordSet::end() const {
+    return words_.end();
+}
+
+uint32_t StopWordSet::Hash(std::string_view word) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char c : word) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Неизменяемое множество стоп-слов для частых проверок.
+// Таблица с открытой адресацией хранит хеш и номер слова, так что
+// проверка слова - одно вычисление хеша и в среднем одно сравнение.
+// Слова длиннее самого длинного стоп-слова отсекаются без хеширования.
+class StopWordSet {
+public:
+    StopWordSet() = default;
+    explicit StopWordSet(const std::set<std::string, std::less<>>& words);
+
+    bool Contains(std::string_view word) const;
+    size_t Size() const;
+    bool Empty() const;
+
+    // слова по возрастанию
+    std::vector<std::string>::const_iterator begin() const;
+    std::vector<std::string>::const_iterator end() const;
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t word_index = EMPTY;
+    };
+
+    static constexpr uint32_t EMPTY = static_cast<uint32_t>(-1);
+
+    static uint32_t Hash(std::string_view word);
+
+    std::vector<std::string> words_;
+    std::vector<Slot> slots_;
+    size_t max_length_ = 0;
+};
@@ -1,16 +1,95 @@
 #include "string_processing.h"
+#include <algorithm>
 
-std::vector<string_view> SplitIntoWords(string_view str)
+#if defined(__SSE2__) && !defined(STRING_PROCESSING_NO_SIMD)
+#include <emmintrin.h>
+#define STRING_PROCESSING_SSE2
+#endif
+
+namespace {
+
+bool IsControlChar(char c) {
+    return static_cast<unsigned char>(c) < ' ';
+}
+
+} // namespace
+
+size_t SplitIntoWords(string_view str, vector<string_view>& words)
 {
-    vector<string_view> result;
-    int64_t pos = str.find_first_not_of(" ");
-    const int64_t pos_end = str.npos;
+    words.clear();
+    const char* const data = str.data();
+    const size_t size = str.size();
+    size_t invalid_pos = string_view::npos;
+    size_t word_start = 0;
+    bool in_word = false;
+    size_t i = 0;
 
-    while (pos != pos_end) {
-        int64_t space = str.find(' ', pos);
-        result.push_back(space == pos_end ? str.substr(pos) : str.substr(pos, space - pos));
-        pos = str.find_first_not_of(" ", space);
+#ifdef STRING_PROCESSING_SSE2
+    // По 16 байт за шаг: маска пробелов и маска управляющих символов.
+    // Биты, где пробел сменяется не-пробелом и наоборот, - границы слов.
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i last_control = _mm_set1_epi8(' ' - 1);
+    uint32_t previous_space = 1;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const uint32_t space_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces));
+        if (invalid_pos == string_view::npos) {
+            const uint32_t control_mask = _mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_max_epu8(chunk, last_control), last_control));
+            if (control_mask != 0) {
+                invalid_pos = i + __builtin_ctz(control_mask);
+            }
+        }
+        uint32_t boundaries = (space_mask ^ ((space_mask << 1) | previous_space)) & 0xFFFF;
+        previous_space = space_mask >> 15;
+        while (boundaries != 0) {
+            const size_t pos = i + __builtin_ctz(boundaries);
+            boundaries &= boundaries - 1;
+            if (in_word) {
+                words.push_back(string_view(data + word_start, pos - word_start));
+            }
+            else {
+                word_start = pos;
+            }
+            in_word = !in_word;
+        }
     }
-    return result;
+#endif
+
+    for (; i < size; ++i) {
+        if (data[i] == ' ') {
+            if (in_word) {
+                words.push_back(string_view(data + word_start, i - word_start));
+                in_word = false;
+            }
+            continue;
+        }
+        if (!in_word) {
+            word_start = i;
+            in_word = true;
+        }
+        if (invalid_pos == string_view::npos && IsControlChar(data[i])) {
+            invalid_pos = i;
+        }
+    }
+    if (in_word) {
+        words.push_back(string_view(data + word_start, size - word_start));
+    }
+
+    if (invalid_pos == string_view::npos) {
+        return words.size();
+    }
+    // управляющий символ не разделяет слова, значит лежит внутри слова
+    const auto it = std::upper_bound(words.begin(), words.end(), data + invalid_pos,
+        [](const char* pos, string_view word) {
+            return pos < word.data();
+        });
+    return (it - words.begin()) - 1;
 }
 
+std::vector<string_view> SplitIntoWords(string_view str)
+{
+    vector<string_view> result;
+    SplitIntoWords(str, result);
+    return result;
+}
@@ -18,3 +18,9 @@ std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContain
 }
 
 std::vector<std::string_view> SplitIntoWords(std::string_view str);
+
+// Разбивает строку на слова по пробелам за один проход, заодно находя
+// управляющие символы (коды 0-31), недопустимые в словах. Слова пишутся
+// в words, прежнее содержимое стирается, но память буфера переиспользуется.
+// Возвращает номер первого слова с управляющим символом или words.size().
+size_t SplitIntoWords(std::string_view str, std::vector<std::string_view>& words);
@@ -0,0 +1,27 @@
+#include "term_arena.h"
+#include <algorithm>
+
+std::string_view TermArena::Store(std::string_view word) {
+    std::lock_guard guard(mutex_);
+    char* data;
+    if (word.size() > BLOCK_SIZE / 4) {
+        // длинное слово получает свой блок, текущий блок продолжает заполняться
+        data = large_blocks_.emplace_back(std::make_unique<char[]>(word.size())).get();
+    }
+    else {
+        if (block_used_ + word.size() > BLOCK_SIZE) {
+            blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            block_used_ = 0;
+        }
+        data = blocks_.back().get() + block_used_;
+        block_used_ += word.size();
+    }
+    std::copy(word.begin(), word.end(), data);
+    used_bytes_ += word.size();
+    return { data, word.size() };
+}
+
+size_t TermArena::GetUsedBytes() const {
+    std::lock_guard guard(mutex_);
+    return used_bytes_;
+}
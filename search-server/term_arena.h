@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Арена для строк слов: строки укладываются подряд в большие блоки,
+// поэтому на слово не тратится отдельное выделение памяти.
+// Строки не перемещаются и не освобождаются до уничтожения арены;
+// место удалённых слов возвращается переносом живых слов в новую арену.
+class TermArena {
+public:
+    std::string_view Store(std::string_view word);
+
+    // сколько байт занято строками
+    size_t GetUsedBytes() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::vector<std::unique_ptr<char[]>> large_blocks_;
+    size_t block_used_ = BLOCK_SIZE;
+    size_t used_bytes_ = 0;
+};
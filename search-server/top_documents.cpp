@@ -0,0 +1,52 @@
+#include "top_documents.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < VALUE) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+TopDocuments::TopDocuments(size_t max_count)
+    : max_count_(max_count) {
+    heap_.reserve(max_count);
+}
+
+void TopDocuments::Add(const Document& document) {
+    if (heap_.size() < max_count_) {
+        heap_.push_back(document);
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+    else if (!heap_.empty() && IsMoreRelevant(document, heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        heap_.back() = document;
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+}
+
+double TopDocuments::GetEntryThreshold() const {
+    if (max_count_ == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (heap_.size() < max_count_) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return heap_.front().relevance - VALUE;
+}
+
+void TopDocuments::Merge(const TopDocuments& other) {
+    for (const Document& document : other.heap_) {
+        Add(document);
+    }
+}
+
+std::vector<Document> TopDocuments::Extract() {
+    std::sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    return std::move(heap_);
+}
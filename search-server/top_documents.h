@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include "document.h"
+
+const double VALUE = 1e-6;
+
+// lhs выше rhs в выдаче: по релевантности, при равной релевантности по рейтингу,
+// затем по меньшему id, чтобы выдача не зависела от порядка обхода документов
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+// Ограниченная куча из max_count лучших документов.
+// Вершина кучи - худший из отобранных, поэтому документ, не попадающий
+// в выдачу, отсекается за одно сравнение.
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t max_count);
+
+    void Add(const Document& document);
+    void Merge(const TopDocuments& other);
+
+    // Документ с релевантностью не выше порога в выдачу уже не попадёт:
+    // он хуже последнего отобранного больше чем на VALUE. Пока выдача
+    // не набрана, порог - минус бесконечность.
+    double GetEntryThreshold() const;
+
+    // отобранные документы от лучшего к худшему
+    std::vector<Document> Extract();
+
+private:
+    size_t max_count_;
+    std::vector<Document> heap_;
+};
@@ -0,0 +1,38 @@
+#include "versioned_search_server.h"
+
+VersionedSearchServer::VersionedSearchServer(SearchServer search_server)
+    : staging_(std::move(search_server))
+    , current_(std::make_shared<const SearchServer>(staging_)) {
+}
+
+std::shared_ptr<const SearchServer> VersionedSearchServer::GetSnapshot() const {
+    return std::atomic_load(&current_);
+}
+
+uint64_t VersionedSearchServer::GetVersion() const {
+    return version_.load();
+}
+
+void VersionedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    std::lock_guard guard(write_mutex_);
+    staging_.AddDocument(document_id, document, status, ratings);
+    Publish();
+}
+
+void VersionedSearchServer::RemoveDocument(int document_id) {
+    std::lock_guard guard(write_mutex_);
+    staging_.RemoveDocument(document_id);
+    Publish();
+}
+
+void VersionedSearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    std::lock_guard guard(write_mutex_);
+    staging_.SetDocumentStatus(document_id, status);
+    Publish();
+}
+
+void VersionedSearchServer::Publish() {
+    std::atomic_store(&current_, std::shared_ptr<const SearchServer>(std::make_shared<const SearchServer>(staging_)));
+    ++version_;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "search_server.h"
+
+// Поисковый сервер, который можно читать во время обновления индекса.
+// Читатели берут неизменяемый снимок текущей версии и ищут по нему без
+// блокировок; писатель меняет рабочую копию и публикует её новой версией.
+// Копия сервера разделяет с предыдущей версией все нетронутые данные,
+// поэтому публикация копирует только изменённые участки индекса.
+// Старая версия освобождается, когда её отпускает последний читатель.
+class VersionedSearchServer {
+public:
+    explicit VersionedSearchServer(SearchServer search_server);
+
+    std::shared_ptr<const SearchServer> GetSnapshot() const;
+    uint64_t GetVersion() const;
+
+    // каждое изменение публикуется отдельной версией
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    // updater(SearchServer&) вносит несколько изменений, которые
+    // публикуются одной версией; удобно для массовой загрузки
+    template <typename Updater>
+    void Update(Updater updater);
+
+private:
+    void Publish();
+
+    std::mutex write_mutex_;
+    SearchServer staging_;
+    std::shared_ptr<const SearchServer> current_;
+    std::atomic<uint64_t> version_ = 0;
+};
+
+template <typename Updater>
+void VersionedSearchServer::Update(Updater updater) {
+    std::lock_guard guard(write_mutex_);
+    try {
+        updater(staging_);
+    }
+    catch (...) {
+        // уже внесённые изменения всё равно становятся видимыми
+        Publish();
+        throw;
+    }
+    Publish();
+}
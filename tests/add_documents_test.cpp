@@ -0,0 +1,93 @@
+// Проверка пакетной загрузки: AddDocuments и загрузка из потока дают тот же
+// сервер, что и последовательные AddDocument, в том числе поверх уже
+// загруженных документов, а пакет с ошибкой не меняет сервер.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server add_documents_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o add_documents_test -ltbb -lpthread
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+vector<DocumentToAdd> ToDocuments(const Corpus& corpus) {
+    vector<DocumentToAdd> documents;
+    for (const auto& [id, document] : corpus) {
+        documents.push_back({ id, document.text, document.status, { document.rating } });
+    }
+    return documents;
+}
+
+void TestAddDocuments() {
+    CorpusGenerator generator(2);
+    const Corpus corpus = MakeCorpus(generator, 0, 5000);
+    const vector<string> queries = generator.MakeQueries(40);
+    for (const RankingModel model : { RankingModel::TF_IDF, RankingModel::BM25 }) {
+        const SearchServer reference = BuildReference(corpus, model);
+        SearchServer search_server(STOP_WORDS);
+        search_server.SetRankingModel(model);
+        search_server.AddDocuments(ToDocuments(corpus));
+        CheckAllSearchModes(search_server, reference, queries, "AddDocuments"s);
+        CheckMatches(search_server, reference, corpus, vector<string>(queries.begin(), queries.begin() + 5), "AddDocuments"s);
+    }
+}
+
+// второй пакет поверх документов, добавленных по одному, и поток из list
+void TestAddDocumentsIncrementally() {
+    CorpusGenerator generator(17);
+    const Corpus first = MakeCorpus(generator, 0, 1000);
+    const Corpus second = MakeCorpus(generator, 1000, 3000);
+    const vector<string> queries = generator.MakeQueries(30);
+    Corpus corpus = first;
+    corpus.insert(second.begin(), second.end());
+    const SearchServer reference = BuildReference(corpus, RankingModel::TF_IDF);
+
+    SearchServer search_server = BuildReference(first, RankingModel::TF_IDF);
+    const vector<DocumentToAdd> documents = ToDocuments(second);
+    const list<DocumentToAdd> stream(documents.begin(), documents.end());
+    search_server.AddDocuments(stream.begin(), stream.end());
+    CheckAllSearchModes(search_server, reference, queries, "stream after AddDocument"s);
+    CheckMatches(search_server, reference, corpus, vector<string>(queries.begin(), queries.begin() + 5), "stream"s);
+}
+
+void TestAddDocumentsError() {
+    CorpusGenerator generator(18);
+    const Corpus corpus = MakeCorpus(generator, 0, 500);
+    const vector<string> queries = generator.MakeQueries(20);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+
+    for (const string& bad_text : { "valid"s, "bad\x01word"s }) {
+        vector<DocumentToAdd> documents = ToDocuments(MakeCorpus(generator, 500, 300));
+        // повтор id уже добавленного документа или недопустимое слово
+        documents.push_back({ bad_text == "valid"s ? 10 : 1000, bad_text, DocumentStatus::ACTUAL, { 1 } });
+        bool thrown = false;
+        try {
+            search_server.AddDocuments(documents);
+        }
+        catch (const invalid_argument&) {
+            thrown = true;
+        }
+        Check(thrown, "invalid batch is added"s);
+        Check(search_server.GetDocumentCount() == static_cast<int>(corpus.size()), "invalid batch changed document count"s);
+        CheckAllSearchModes(search_server, BuildReference(corpus, RankingModel::TF_IDF), queries, "after invalid batch"s);
+    }
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestAddDocuments);
+    RUN_TEST(TestAddDocumentsIncrementally);
+    RUN_TEST(TestAddDocumentsError);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+// Проверка оценки BM25: выдача при любой стратегии поиска совпадает
+// с прямым подсчётом по текстам документов, в том числе после смены
+// параметров, добавления документов и у открытого сохранённого индекса.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server bm25_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o bm25_test -ltbb -lpthread
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+void CheckBm25MatchesDefinition(const SearchServer& search_server, const Corpus& corpus, const vector<string>& queries,
+    const Bm25Params& params, const string& context) {
+    const DefinitionScorer scorer(corpus);
+    for (const string& query : queries) {
+        for (const RetrievalStrategy strategy : ALL_STRATEGIES) {
+            for (const size_t max_count : MAX_COUNTS) {
+                ForEachPredicate([&](const string& name, const auto&, const PlainPredicate& plain_predicate) {
+                    scorer.CheckTopDocuments(search_server.FindTopDocuments(query, plain_predicate, max_count, strategy),
+                        query, RankingModel::BM25, plain_predicate, max_count, context + " ["s + query + "] "s + name, params);
+                });
+            }
+        }
+    }
+}
+
+void TestBm25MatchesDefinition() {
+    CorpusGenerator generator(1);
+    const Corpus corpus = MakeCorpus(generator, 0, 2000);
+    const vector<string> queries = generator.MakeQueries(60);
+    CheckBm25MatchesDefinition(BuildReference(corpus, RankingModel::BM25), corpus, queries, {}, "built"s);
+}
+
+// поправки документов на длину пересчитываются при смене параметров,
+// а средняя длина учитывает документы, добавленные после смены
+void TestBm25Params() {
+    CorpusGenerator generator(11);
+    Corpus corpus = MakeCorpus(generator, 0, 1500);
+    const vector<string> queries = generator.MakeQueries(30);
+    SearchServer search_server = BuildReference(corpus, RankingModel::BM25);
+
+    const Bm25Params params{ 2.0, 0.3 };
+    search_server.SetRankingModel(RankingModel::BM25, params);
+    CheckBm25MatchesDefinition(search_server, corpus, queries, params, "after SetRankingModel"s);
+
+    const Corpus added = MakeCorpus(generator, 1500, 500);
+    AddCorpus(search_server, added);
+    corpus.insert(added.begin(), added.end());
+    for (int id = 0; id < 2000; id += 7) {
+        search_server.RemoveDocument(id);
+        corpus.erase(id);
+    }
+    CheckBm25MatchesDefinition(search_server, corpus, queries, params, "after changes"s);
+
+    search_server.SetRankingModel(RankingModel::BM25);
+    CheckBm25MatchesDefinition(search_server, corpus, queries, {}, "default parameters"s);
+}
+
+// поправки документов сохранённого индекса считаются при открытии
+void TestBm25OpenedIndex() {
+    CorpusGenerator generator(12);
+    Corpus corpus = MakeCorpus(generator, 0, 1500);
+    const vector<string> queries = generator.MakeQueries(30);
+    const string path = (filesystem::temp_directory_path() / "bm25_test.index"s).string();
+    BuildReference(corpus, RankingModel::BM25).SaveIndex(path);
+    {
+        SearchServer search_server = SearchServer::OpenIndex(path);
+        search_server.SetRankingModel(RankingModel::BM25);
+        CheckBm25MatchesDefinition(search_server, corpus, queries, {}, "opened"s);
+
+        const Bm25Params params{ 0.9, 0.9 };
+        search_server.SetRankingModel(RankingModel::BM25, params);
+        const Corpus added = MakeCorpus(generator, 1500, 300);
+        AddCorpus(search_server, added);
+        corpus.insert(added.begin(), added.end());
+        CheckBm25MatchesDefinition(search_server, corpus, queries, params, "opened and changed"s);
+    }
+    filesystem::remove(path);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestBm25MatchesDefinition);
+    RUN_TEST(TestBm25Params);
+    RUN_TEST(TestBm25OpenedIndex);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// Проверка фильтров документов: маски статусов и рейтингов совпадают
+// с поэлементной проверкой при любой длине и выравнивании, а поиск
+// с StatusFilter, RatingFilter и DocumentIdFilter выдаёт то же, что и
+// с обычным предикатом, в том числе при номерах удалённых документов.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server document_filter_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o document_filter_test -ltbb -lpthread
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "document_filter.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+void TestFillMasks() {
+    mt19937 random(5);
+    const int rating_values[] = { numeric_limits<int>::min(), -10, -1, 0, 1, 3, 10, numeric_limits<int>::max() };
+    for (size_t count = 0; count <= 70; ++count) {
+        for (size_t offset = 0; offset < 3; ++offset) {
+            vector<uint8_t> statuses(offset + count);
+            vector<int> ratings(offset + count);
+            for (size_t i = 0; i < statuses.size(); ++i) {
+                statuses[i] = random() % 5 == 0 ? NO_DOCUMENT_STATUS : static_cast<uint8_t>(random() % 4);
+                ratings[i] = rating_values[random() % size(rating_values)];
+            }
+            const string context = "count "s + to_string(count) + " offset "s + to_string(offset);
+            vector<uint8_t> mask(count);
+            for (const DocumentStatus status : ALL_STATUSES) {
+                FillStatusMask(statuses.data() + offset, count, status, mask.data());
+                for (size_t i = 0; i < count; ++i) {
+                    const bool admitted = statuses[offset + i] == static_cast<uint8_t>(status);
+                    Check(mask[i] == (admitted ? 0xFF : 0), context + ": wrong status mask"s);
+                }
+            }
+            for (const auto& [min_rating, max_rating] : { pair{ -1, 3 }, pair{ 0, 0 }, pair{ 5, -5 },
+                pair{ numeric_limits<int>::min(), numeric_limits<int>::max() } }) {
+                FillRatingMask(statuses.data() + offset, ratings.data() + offset, count, min_rating, max_rating, mask.data());
+                for (size_t i = 0; i < count; ++i) {
+                    const bool admitted = statuses[offset + i] != NO_DOCUMENT_STATUS
+                        && min_rating <= ratings[offset + i] && ratings[offset + i] <= max_rating;
+                    Check(mask[i] == (admitted ? 0xFF : 0), context + ": wrong rating mask"s);
+                }
+            }
+        }
+    }
+}
+
+// выдача с фильтром совпадает с выдачей того же сервера с обычным предикатом
+template <typename Filter>
+void CheckFilter(const SearchServer& search_server, const vector<string>& queries, const Filter& filter,
+    const string& context) {
+    const PlainPredicate plain_predicate = filter;
+    for (const string& query : queries) {
+        for (const size_t max_count : MAX_COUNTS) {
+            const vector<Document> expected = search_server.FindTopDocuments(query, plain_predicate, max_count);
+            for (const RetrievalStrategy strategy : ALL_STRATEGIES) {
+                const string where = context + " ["s + query + "] strategy "s + to_string(static_cast<int>(strategy));
+                CheckSameDocuments(search_server.FindTopDocuments(execution::seq, query, filter, max_count, strategy),
+                    expected, where + " seq"s);
+                CheckSameDocuments(search_server.FindTopDocuments(execution::par, query, filter, max_count, strategy),
+                    expected, where + " par"s);
+            }
+        }
+    }
+}
+
+void TestFiltersMatchPlainPredicate() {
+    CorpusGenerator generator(19);
+    const Corpus corpus = MakeCorpus(generator, 0, 8000);
+    const vector<string> queries = generator.MakeQueries(20);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    // номера удалённых документов остаются в столбцах без документа
+    for (int id = 0; id < 8000; id += 3) {
+        search_server.RemoveDocument(id);
+    }
+    vector<int> removed;
+    for (int id = 1; id < 8000; id += 11) {
+        removed.push_back(id);
+    }
+    search_server.RemoveDocuments(removed);
+
+    for (const string& context : { "before purge"s, "after purge"s }) {
+        for (const DocumentStatus status : ALL_STATUSES) {
+            CheckFilter(search_server, queries, StatusFilter{ status }, context + " StatusFilter"s);
+        }
+        CheckFilter(search_server, queries, RatingFilter{}, context + " RatingFilter all"s);
+        CheckFilter(search_server, queries, RatingFilter{ 2, 2 }, context + " RatingFilter single"s);
+        CheckFilter(search_server, queries, RatingFilter{ 5, -5 }, context + " RatingFilter empty"s);
+        CheckFilter(search_server, queries, RatingFilter{ numeric_limits<int>::min(), 0 }, context + " RatingFilter below"s);
+        // повторы, неизвестные и удалённые id
+        CheckFilter(search_server, queries, DocumentIdFilter(vector<int>{ 9, 4, 4, 3, 12, 100000, -1, 2, 5000, 5000 }),
+            context + " DocumentIdFilter"s);
+        CheckFilter(search_server, queries, DocumentIdFilter(vector<int>{}), context + " DocumentIdFilter empty"s);
+        search_server.PurgeRemovedDocuments();
+    }
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestFillMasks);
+    RUN_TEST(TestFiltersMatchPlainPredicate);
+    return passed ? 0 : 1;
+}
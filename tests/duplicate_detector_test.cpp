@@ -0,0 +1,149 @@
+// Проверка поиска дубликатов: FindDuplicates и DuplicateFilter находят
+// документы с тем же множеством слов, совпадение хешей множеств без
+// совпадения слов не делает документ дубликатом, а почти совпадающие
+// документы (MinHash) отбираются только при мере Жаккара не ниже порога.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server duplicate_detector_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o duplicate_detector_test -ltbb -lpthread
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "duplicate_detector.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+set<string> GetWordSet(const string& text) {
+    set<string> words;
+    istringstream in(text);
+    for (string word; in >> word;) {
+        if (word != "and"s && word != "with"s) {
+            words.insert(word);
+        }
+    }
+    return words;
+}
+
+double GetJaccard(const set<string>& lhs, const set<string>& rhs) {
+    vector<string> common;
+    set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), back_inserter(common));
+    return common.size() * 1.0 / (lhs.size() + rhs.size() - common.size());
+}
+
+// каждый дубликат совпадает с документом меньшего id или близок к нему
+void CheckDuplicates(const Corpus& corpus, const vector<int>& duplicates, double similarity, const string& context) {
+    for (const int id : duplicates) {
+        const set<string> words = GetWordSet(corpus.at(id).text);
+        const bool found = any_of(corpus.begin(), corpus.find(id), [&](const auto& entry) {
+            return GetJaccard(GetWordSet(entry.second.text), words) >= similarity;
+            });
+        Check(found, context + ": document "s + to_string(id) + " is not a duplicate"s);
+    }
+}
+
+void TestExactDuplicates() {
+    CorpusGenerator generator(15);
+    Corpus corpus = MakeCorpus(generator, 0, 500);
+    // перестановки, повторы и стоп-слова не меняют множество слов
+    set<int> expected;
+    for (int id = 500; id < 600; ++id) {
+        string text = corpus.at(id - 500).text;
+        istringstream in(text);
+        vector<string> words{ istream_iterator<string>(in), istream_iterator<string>() };
+        reverse(words.begin(), words.end());
+        words.push_back(words.front());
+        words.push_back("with"s);
+        string permuted;
+        for (const string& word : words) {
+            permuted += word + " "s;
+        }
+        corpus[id] = { permuted, DocumentStatus::ACTUAL, 1 };
+        expected.insert(id);
+    }
+    // документы меньшего id могут совпасть между собой случайно
+    for (const auto& [id, document] : corpus) {
+        for (auto it = corpus.begin(); it->first < id && id < 500; ++it) {
+            if (GetWordSet(it->second.text) == GetWordSet(document.text)) {
+                expected.insert(id);
+                break;
+            }
+        }
+    }
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    const vector<int> duplicates = FindDuplicates(search_server);
+    Check(set<int>(duplicates.begin(), duplicates.end()) == expected, "FindDuplicates"s);
+
+    RemoveDuplicates(search_server);
+    Check(search_server.GetDocumentCount() == static_cast<int>(corpus.size() - expected.size()), "RemoveDuplicates"s);
+
+    SearchServer filtered(STOP_WORDS);
+    DuplicateFilter filter(filtered);
+    for (const auto& [id, document] : corpus) {
+        const int duplicate_id = filter.AddDocument(id, document.text, document.status, { document.rating });
+        Check((duplicate_id != DuplicateDetector::NO_DUPLICATE) == (expected.count(id) > 0),
+            "DuplicateFilter of document "s + to_string(id));
+    }
+}
+
+// совпадение хешей множеств решается сверкой слов
+void TestSetHashCollision() {
+    const vector<string> first_words = { "alpha"s, "beta"s };
+    const vector<string> second_words = { "gamma"s, "delta"s };
+    for (const double similarity : { 1.0, 0.5 }) {
+        DuplicateDetector detector(similarity);
+        const DuplicateDetector::Fingerprint first = detector.MakeFingerprint({ first_words.begin(), first_words.end() });
+        DuplicateDetector::Fingerprint second = detector.MakeFingerprint({ second_words.begin(), second_words.end() });
+        second.set_hash = first.set_hash;
+        second.band_hashes = first.band_hashes;
+        detector.Add(1, first);
+        Check(detector.FindDuplicate(second) == DuplicateDetector::NO_DUPLICATE,
+            "colliding fingerprint is a duplicate, similarity "s + to_string(similarity));
+        Check(detector.FindDuplicate(first) == 1, "same fingerprint is not a duplicate"s);
+    }
+}
+
+void TestNearDuplicates() {
+    Corpus corpus;
+    for (int id = 0; id < 300; ++id) {
+        ModelDocument document;
+        for (int i = 0; i < 20; ++i) {
+            document.text += "d"s + to_string(id) + "_"s + to_string(i) + " "s;
+        }
+        corpus[id] = document;
+    }
+    // копии с одним заменённым словом: мера Жаккара 19 / 21
+    for (int id = 300; id < 400; ++id) {
+        corpus[id].text = corpus.at(id - 300).text + "extra"s + to_string(id);
+        corpus[id].text.replace(0, corpus[id].text.find(' '), "other"s + to_string(id));
+    }
+    const SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    for (const double similarity : { 0.8, 0.95 }) {
+        const vector<int> duplicates = FindDuplicates(search_server, similarity);
+        CheckDuplicates(corpus, duplicates, similarity, "similarity "s + to_string(similarity));
+        if (similarity < 19.0 / 21.0) {
+            Check(duplicates.size() >= 90, "near duplicates are missed"s);
+        }
+    }
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestExactDuplicates);
+    RUN_TEST(TestSetHashCollision);
+    RUN_TEST(TestNearDuplicates);
+    return passed ? 0 : 1;
+}
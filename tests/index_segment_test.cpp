@@ -0,0 +1,155 @@
+// Проверка сохранённого индекса: сервер, открытый из файла, и изменения
+// поверх него совпадают с сервером, построенным заново, а повреждённый
+// или обрезанный файл не открывается (runtime_error) либо открывается
+// с данными в пределах своих секций.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server index_segment_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o index_segment_test -ltbb -lpthread
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+vector<char> ReadFile(const string& path) {
+    ifstream in(path, ios::binary);
+    return vector<char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const vector<char>& bytes) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), bytes.size());
+}
+
+// Сохранённый индекс и изменения поверх него. Копия сервера
+// разделяет данные с оригиналом, изменения копии не видны оригиналу.
+void TestSaveOpenRoundTrip() {
+    CorpusGenerator generator(5);
+    Corpus corpus = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(25);
+    const string path = (filesystem::temp_directory_path() / "index_segment_test.index"s).string();
+
+    SearchServer original = BuildReference(corpus, RankingModel::TF_IDF);
+    original.SaveIndex(path);
+    SearchServer opened = SearchServer::OpenIndex(path);
+    CheckAllSearchModes(opened, original, queries, "opened"s);
+    CheckMatches(opened, original, corpus, queries, "opened"s);
+
+    const SearchServer snapshot = opened;
+    const Corpus added = MakeCorpus(generator, 3000, 700);
+    AddCorpus(opened, added);
+    corpus.insert(added.begin(), added.end());
+    vector<int> removed;
+    for (int id = 2; id < 3700; id += 9) {
+        removed.push_back(id);
+        corpus.erase(id);
+    }
+    opened.RemoveDocuments(removed);
+    opened.RemoveDocument(1);
+    corpus.erase(1);
+    for (int id = 3; id < 3700; id += 4) {
+        if (corpus.count(id) > 0) {
+            corpus[id].status = generator.MakeStatus();
+            opened.SetDocumentStatus(id, corpus[id].status);
+        }
+    }
+    opened.PurgeRemovedDocuments();
+    const SearchServer reference = BuildReference(corpus, RankingModel::TF_IDF);
+    CheckAllSearchModes(opened, reference, queries, "opened and changed"s);
+    CheckMatches(opened, reference, corpus, queries, "opened and changed"s);
+    CheckAllSearchModes(snapshot, original, queries, "copy of opened"s);
+
+    // повторное сохранение сервера с сегментом и изменениями
+    opened.SaveIndex(path);
+    const SearchServer reopened = SearchServer::OpenIndex(path);
+    CheckAllSearchModes(reopened, reference, queries, "reopened"s);
+    filesystem::remove(path);
+}
+
+// все виды обращений к данным сегмента
+void UseIndex(SearchServer& search_server, const vector<string>& queries) {
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL);
+        for (const int document_id : search_server) {
+            search_server.MatchDocument(query, document_id);
+        }
+    }
+    for (const int document_id : search_server) {
+        search_server.GetWordFrequencies(document_id);
+    }
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    search_server.RemoveDocuments(document_ids);
+    search_server.PurgeRemovedDocuments();
+}
+
+// Каждое 4-байтовое слово файла по очереди заменяется недопустимым
+// значением. Файл либо не открывается, либо все обращения к нему
+// остаются в пределах файла (проверяется сборкой с -fsanitize=address).
+void TestCorruptedIndex() {
+    CorpusGenerator generator(13);
+    const Corpus corpus = MakeCorpus(generator, 0, 40);
+    const vector<string> queries = generator.MakeQueries(5);
+    const string path = (filesystem::temp_directory_path() / "index_segment_test.index"s).string();
+    BuildReference(corpus, RankingModel::TF_IDF).SaveIndex(path);
+    const vector<char> bytes = ReadFile(path);
+
+    int rejected = 0;
+    for (const uint32_t value : { 0x7FFFFFFFu, 0x80000000u, 0x00010000u }) {
+        for (size_t offset = 0; offset + sizeof(value) <= bytes.size(); offset += sizeof(value)) {
+            vector<char> corrupted = bytes;
+            memcpy(corrupted.data() + offset, &value, sizeof(value));
+            WriteFile(path, corrupted);
+            optional<SearchServer> search_server;
+            try {
+                search_server = SearchServer::OpenIndex(path);
+            }
+            catch (const runtime_error&) {
+                ++rejected;
+                continue;
+            }
+            try {
+                UseIndex(*search_server, queries);
+            }
+            catch (const exception&) {
+                // изменённые слова и id могут не найтись или стать недопустимыми
+            }
+        }
+    }
+    Check(rejected > 0, "no corrupted index is rejected"s);
+
+    for (size_t size = 0; size < bytes.size(); size += 8) {
+        WriteFile(path, vector<char>(bytes.begin(), bytes.begin() + size));
+        bool thrown = false;
+        try {
+            SearchServer::OpenIndex(path);
+        }
+        catch (const runtime_error&) {
+            thrown = true;
+        }
+        Check(thrown, "index truncated to "s + to_string(size) + " bytes is opened"s);
+    }
+    filesystem::remove(path);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestSaveOpenRoundTrip);
+    RUN_TEST(TestCorruptedIndex);
+    return passed ? 0 : 1;
+}
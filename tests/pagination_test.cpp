@@ -0,0 +1,126 @@
+// Проверка постраничного просмотра: страницы Paginator покрывают диапазон
+// по порядку для любых итераторов, страницы SearchResultCursor в любом
+// порядке обращения складываются в полную выдачу FindTopDocuments.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server pagination_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       ../search-server/search_result_cursor.cpp
+//       -o pagination_test -ltbb -lpthread
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "paginator.h"
+#include "search_result_cursor.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+// страницы по порядку дают исходные элементы, все страницы кроме
+// последней полные
+template <typename Container>
+void CheckPages(const Container& items, size_t page_size, const string& context) {
+    vector<int> joined;
+    size_t page_count = 0;
+    for (const auto& page : Paginate(items, page_size)) {
+        const size_t size = distance(page.begin, page.end);
+        Check(size > 0 && size <= page_size, context + ": wrong page size"s);
+        Check(size == page_size || joined.size() + size == items.size(), context + ": short page in the middle"s);
+        joined.insert(joined.end(), page.begin, page.end);
+        ++page_count;
+    }
+    Check(joined == vector<int>(items.begin(), items.end()), context + ": pages differ from the range"s);
+    Check(page_count == (items.size() + page_size - 1) / page_size, context + ": wrong page count"s);
+}
+
+void TestPaginator() {
+    for (const size_t item_count : { 0, 1, 7, 12, 100 }) {
+        vector<int> items(item_count);
+        for (size_t i = 0; i < item_count; ++i) {
+            items[i] = static_cast<int>(i * 3);
+        }
+        for (const size_t page_size : { 1, 3, 4, 12, 200 }) {
+            const string context = to_string(item_count) + " items by "s + to_string(page_size);
+            CheckPages(items, page_size, context);
+            CheckPages(list<int>(items.begin(), items.end()), page_size, context + " in list"s);
+        }
+    }
+    bool thrown = false;
+    try {
+        Paginate(vector<int>(5), 0);
+    }
+    catch (const invalid_argument&) {
+        thrown = true;
+    }
+    Check(thrown, "zero page size is accepted"s);
+}
+
+// страница page_index курсора совпадает с частью полной выдачи
+void CheckPage(SearchResultCursor& cursor, const vector<Document>& expected, size_t page_index, const string& context) {
+    const size_t page_size = cursor.GetPageSize();
+    const size_t first = min(page_index * page_size, expected.size());
+    const size_t last = min(first + page_size, expected.size());
+    const SearchResultCursor::Page page = cursor.GetPage(page_index);
+    CheckSameDocuments(vector<Document>(page.begin, page.end),
+        vector<Document>(expected.begin() + first, expected.begin() + last),
+        context + " page "s + to_string(page_index));
+}
+
+void TestSearchResultCursor() {
+    CorpusGenerator generator(3);
+    const Corpus corpus = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(40);
+    const SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    const PlainPredicate not_banned = [](int, DocumentStatus status, int) { return status != DocumentStatus::BANNED; };
+    for (const string& query : queries) {
+        const string context = "["s + query + "]"s;
+        const vector<Document> expected = search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, corpus.size());
+
+        // по порядку
+        SearchResultCursor cursor(search_server, query, DocumentStatus::ACTUAL, 3);
+        Check(cursor.GetDocumentCount() == expected.size(), context + ": wrong document count"s);
+        Check(cursor.GetPageCount() == (expected.size() + 2) / 3, context + ": wrong page count"s);
+        for (size_t page = 0; page <= cursor.GetPageCount(); ++page) {
+            CheckPage(cursor, expected, page, context);
+        }
+
+        // с конца и вразброс: упорядоченные страницы не меняются
+        SearchResultCursor backward(search_server, query, DocumentStatus::ACTUAL, 4);
+        for (size_t page = backward.GetPageCount() + 1; page-- > 0;) {
+            CheckPage(backward, expected, page, context + " backward"s);
+        }
+        SearchResultCursor jumping(search_server, query, DocumentStatus::ACTUAL, 5);
+        for (const size_t page : { 2, 0, 7, 1, 7, 3 }) {
+            CheckPage(jumping, expected, page, context + " jumping"s);
+        }
+
+        SearchResultCursor filtered(search_server, query, not_banned, 6);
+        const vector<Document> expected_filtered = search_server.FindTopDocuments(query, not_banned, corpus.size());
+        for (size_t page = 0; page < filtered.GetPageCount(); ++page) {
+            CheckPage(filtered, expected_filtered, page, context + " predicate"s);
+        }
+    }
+    bool thrown = false;
+    try {
+        SearchResultCursor(search_server, queries.front(), DocumentStatus::ACTUAL, 0);
+    }
+    catch (const invalid_argument&) {
+        thrown = true;
+    }
+    Check(thrown, "zero page size is accepted"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestPaginator);
+    RUN_TEST(TestSearchResultCursor);
+    return passed ? 0 : 1;
+}
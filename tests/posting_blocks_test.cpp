@@ -0,0 +1,144 @@
+// Проверка сжатых списков вхождений (PostingBlocks): после добавлений,
+// удалений и замены списка обход, поиск, курсор и проверка принадлежности
+// совпадают с обычным словарём, а изменения копии не видны оригиналу.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server posting_blocks_test.cpp
+//       ../search-server/posting_blocks.cpp -o posting_blocks_test
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "posting_blocks.h"
+
+using namespace std;
+
+void Check(bool condition, const string& message) {
+    if (!condition) {
+        throw runtime_error(message);
+    }
+}
+
+using Model = map<int, double>;
+
+void CheckSameAsModel(const PostingBlocks& blocks, const Model& model, mt19937& random, const string& context) {
+    Check(blocks.Size() == model.size() && blocks.Empty() == model.empty(), context + ": size"s);
+    if (!model.empty()) {
+        Check(blocks.GetLastId() == prev(model.end())->first, context + ": last id"s);
+    }
+
+    Model listed;
+    auto collect = [&](int id, double freq) {
+        listed[id] = freq;
+    };
+    blocks.ForEach(collect);
+    Check(listed == model, context + ": ForEach"s);
+
+    const int bound = model.empty() ? 100 : prev(model.end())->first + 100;
+    for (int i = 0; i < 20; ++i) {
+        int first = static_cast<int>(random() % bound);
+        int last = static_cast<int>(random() % bound);
+        if (first > last) {
+            swap(first, last);
+        }
+        Model ranged;
+        auto collect_range = [&](int id, double freq) {
+            ranged[id] = freq;
+        };
+        blocks.ForEachInRange(first, last, collect_range);
+        Check(ranged == Model(model.lower_bound(first), model.lower_bound(last)), context + ": ForEachInRange"s);
+    }
+
+    // возрастающие id с шагами разной длины
+    PostingBlocks::Cursor cursor(blocks);
+    PostingBlocks::Seeker seeker(blocks);
+    for (int id = 0; id < bound; id += 1 + static_cast<int>(random() % (random() % 8 == 0 ? 2000 : 20))) {
+        const auto it = model.lower_bound(id);
+        if (random() % 4 == 0) {
+            cursor.ShallowAdvance(id);
+            Check(it == model.end() || cursor.GetBlockLastId() >= it->first, context + ": ShallowAdvance block"s);
+            Check(it == model.end() || cursor.GetBlockMaxFreq() >= it->second, context + ": ShallowAdvance max freq"s);
+        }
+        cursor.Advance(id);
+        Check(it == model.end() ? cursor.GetId() == PostingBlocks::Cursor::END
+            : cursor.GetId() == it->first && cursor.GetFreq() == it->second, context + ": Advance to "s + to_string(id));
+        Check(seeker.Contains(id) == (model.count(id) > 0), context + ": Seeker "s + to_string(id));
+        Check(blocks.Contains(id) == (model.count(id) > 0), context + ": Contains "s + to_string(id));
+    }
+    for (const auto& [id, freq] : model) {
+        Check(blocks.GetMaxFreq() >= freq, context + ": GetMaxFreq"s);
+    }
+}
+
+void TestPostingBlocks() {
+    mt19937 random(14);
+    PostingBlocks blocks;
+    Model model;
+    int next_id = 0;
+    const auto append = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            // большие шаги требуют широких кодов
+            next_id += 1 + static_cast<int>(random() % (random() % 16 == 0 ? 100000 : 10));
+            const double freq = uniform_real_distribution<double>(0.0, 1.0)(random);
+            blocks.Append(next_id, freq);
+            model[next_id] = freq;
+        }
+    };
+    const auto remove = [&](size_t count) {
+        for (size_t i = 0; i < count && !model.empty(); ++i) {
+            auto it = model.begin();
+            advance(it, random() % model.size());
+            Check(blocks.Remove(it->first), "Remove of present id"s);
+            model.erase(it);
+        }
+        Check(!blocks.Remove(-1), "Remove of absent id"s);
+    };
+
+    // несколько групп блоков и неполный хвост
+    append(3 * PostingBlocks::GROUP_SIZE * PostingBlocks::BLOCK_SIZE + 77);
+    CheckSameAsModel(blocks, model, random, "appended"s);
+    remove(2000);
+    CheckSameAsModel(blocks, model, random, "removed"s);
+
+    // копия разделяет группы с оригиналом
+    const PostingBlocks original = blocks;
+    const Model original_model = model;
+    remove(300);
+    append(1000);
+    CheckSameAsModel(blocks, model, random, "changed copy"s);
+    CheckSameAsModel(original, original_model, random, "original"s);
+
+    // удаление последних id блока удаляет блок
+    while (model.size() > 100) {
+        remove(model.size() / 3 + 1);
+    }
+    CheckSameAsModel(blocks, model, random, "mostly removed"s);
+    remove(model.size());
+    CheckSameAsModel(blocks, model, random, "empty"s);
+    append(500);
+    CheckSameAsModel(blocks, model, random, "appended after emptying"s);
+
+    vector<int> ids;
+    vector<double> freqs;
+    for (const auto& [id, freq] : original_model) {
+        ids.push_back(id);
+        freqs.push_back(freq);
+    }
+    blocks.Assign(ids.data(), freqs.data(), ids.size());
+    CheckSameAsModel(blocks, original_model, random, "assigned"s);
+}
+
+int main() {
+    cerr << "decoder: "s << GetPostingDecoderName() << endl;
+    try {
+        TestPostingBlocks();
+        cerr << "TestPostingBlocks OK"s << endl;
+    }
+    catch (const exception& e) {
+        cerr << "TestPostingBlocks fail: "s << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Проверка пакетного поиска: ProcessQueries, ProcessQueriesJoined и
+// FindTopDocumentsBatch выдают по каждому запросу то же, что и
+// FindTopDocuments, в том числе для повторяющихся запросов.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server process_queries_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       ../search-server/process_queries.cpp
+//       -o process_queries_test -ltbb -lpthread
+#include <string>
+#include <vector>
+#include "process_queries.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+void TestBatchQueries() {
+    CorpusGenerator generator(3);
+    const Corpus corpus = MakeCorpus(generator, 0, 3000);
+    vector<string> queries = generator.MakeQueries(60);
+    // повторы выполняются один раз, но выдаются каждому
+    queries.insert(queries.end(), queries.begin(), queries.begin() + 10);
+    const SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+
+    const PlainPredicate not_banned = [](int, DocumentStatus status, int) { return status != DocumentStatus::BANNED; };
+    vector<vector<Document>> batch_results(queries.size());
+    search_server.FindTopDocumentsBatch(queries, not_banned, [&](size_t index, vector<Document> documents) {
+        batch_results[index] = move(documents);
+        }, 7);
+    const vector<vector<Document>> processed = ProcessQueries(search_server, queries);
+    vector<Document> joined_expected;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        CheckSameDocuments(batch_results[i], search_server.FindTopDocuments(queries[i], not_banned, 7),
+            "FindTopDocumentsBatch ["s + queries[i] + "]"s);
+        const vector<Document> expected = search_server.FindTopDocuments(queries[i]);
+        CheckSameDocuments(processed[i], expected, "ProcessQueries ["s + queries[i] + "]"s);
+        joined_expected.insert(joined_expected.end(), expected.begin(), expected.end());
+    }
+    CheckSameDocuments(ProcessQueriesJoined(search_server, queries), joined_expected, "ProcessQueriesJoined"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestBatchQueries);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// Проверка QueryCache: кеш возвращает то же, что и сервер, после любого
+// изменения индекса, через кеш или мимо него.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server query_cache_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       ../search-server/query_cache.cpp
+//       -o query_cache_test -ltbb -lpthread
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "query_cache.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+// Кеш возвращает то же, что и сервер, после любого изменения, в том числе
+// сделанного мимо кеша: очистки, смены модели оценки, замены документа
+// документом другой длины.
+void TestQueryCache() {
+    CorpusGenerator generator(7);
+    Corpus corpus = MakeCorpus(generator, 0, 2000);
+    const vector<string> queries = generator.MakeQueries(30);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    QueryCache cache(search_server, 64);
+
+    const auto check_cache = [&](const string& context) {
+        // дважды: промах заполняет запись, попадание читает её
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const string& query : queries) {
+                for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                    CheckSameDocuments(cache.FindTopDocuments(query, status, 5), search_server.FindTopDocuments(query, status, 5),
+                        context + " ["s + query + "]"s);
+                }
+            }
+        }
+    };
+    check_cache("initial"s);
+    const uint64_t hit_count = cache.GetHitCount();
+    check_cache("unchanged"s);
+    Check(cache.GetHitCount() > hit_count, "cache is never hit"s);
+
+    cache.AddDocument(5000, "w0 w1 w2 w3"s, DocumentStatus::ACTUAL, { 3 });
+    // запись через кеш сбрасывает его: первый же запрос - промах
+    const uint64_t miss_count = cache.GetMissCount();
+    cache.FindTopDocuments(queries.front(), DocumentStatus::ACTUAL, 5);
+    Check(cache.GetMissCount() == miss_count + 1, "cache is not cleared by AddDocument"s);
+    check_cache("after AddDocument"s);
+    cache.RemoveDocument(5000);
+    cache.RemoveDocument(10);
+    check_cache("after RemoveDocument"s);
+    cache.SetDocumentStatus(11, DocumentStatus::BANNED);
+    check_cache("after SetDocumentStatus"s);
+
+    vector<int> removed;
+    for (int id = 100; id < 2000; id += 3) {
+        removed.push_back(id);
+    }
+    search_server.RemoveDocuments(removed);
+    check_cache("after RemoveDocuments"s);
+    search_server.PurgeRemovedDocuments();
+    check_cache("after PurgeRemovedDocuments"s);
+
+    cache.SetRankingModel(RankingModel::BM25);
+    check_cache("after QueryCache::SetRankingModel"s);
+    search_server.SetRankingModel(RankingModel::BM25, { 2.0, 0.5 });
+    check_cache("after SearchServer::SetRankingModel"s);
+
+    // число документов то же, слова запросов не тронуты, меняется средняя длина
+    string long_text;
+    for (int i = 0; i < 500; ++i) {
+        long_text += "x"s + to_string(i) + " "s;
+    }
+    search_server.RemoveDocument(20);
+    search_server.AddDocument(20, long_text, DocumentStatus::ACTUAL, { 1 });
+    check_cache("after replacing a document"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestQueryCache);
+    return passed ? 0 : 1;
+}
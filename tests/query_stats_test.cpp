@@ -0,0 +1,113 @@
+// Проверка статистики запросов: счётчики QueryStats согласованы с выдачей,
+// параллельный поиск считает то же, что и последовательный, сводные
+// гистограммы учитывают каждый запрос. При сборке с SEARCH_SERVER_NO_STATS
+// проверяется, что статистика не собирается.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server query_stats_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o query_stats_test -ltbb -lpthread
+#include <cstdint>
+#include <execution>
+#include <string>
+#include <vector>
+#include "query_stats.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+void TestLog2Histogram() {
+    Log2Histogram histogram;
+    for (const uint64_t value : { 0, 1, 2, 3, 4, 7, 8, 1000 }) {
+        histogram.Add(value);
+    }
+    histogram.Add(UINT64_MAX);
+    Check(histogram.GetCount() == 9, "wrong histogram count"s);
+    const uint64_t expected[] = { 1, 1, 2, 2, 1 };
+    for (size_t bucket = 0; bucket < 5; ++bucket) {
+        Check(histogram.GetBucketCount(bucket) == expected[bucket], "wrong count in bucket "s + to_string(bucket));
+    }
+    Check(histogram.GetBucketCount(10) == 1 && histogram.GetBucketCount(Log2Histogram::BUCKET_COUNT - 1) == 1,
+        "wrong count of large values"s);
+    Check(Log2Histogram::GetBucketBound(0) == 0 && Log2Histogram::GetBucketBound(3) == 7
+        && Log2Histogram::GetBucketBound(Log2Histogram::BUCKET_COUNT - 1) == UINT64_MAX, "wrong bucket bounds"s);
+    Check(histogram.GetQuantileBound(0.5) == 7 && histogram.GetQuantileBound(1.0) == UINT64_MAX, "wrong quantile bounds"s);
+    histogram.Clear();
+    Check(histogram.GetCount() == 0, "histogram is not cleared"s);
+}
+
+void TestQueryStats() {
+    CorpusGenerator generator(16);
+    const Corpus corpus = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(30);
+    const SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    const auto reject_all = [](int, DocumentStatus, int) { return false; };
+    uint64_t filtered_by_minus_words = 0;
+    for (const string& query : queries) {
+        const string context = "["s + query + "]"s;
+        QueryStats stats;
+        const vector<Document> documents = search_server.FindTopDocuments(execution::seq, query,
+            PlainPredicate([](int, DocumentStatus, int) { return true; }), corpus.size(), RetrievalStrategy::EXHAUSTIVE, &stats);
+        QueryStats parallel_stats;
+        search_server.FindTopDocuments(execution::par, query, PlainPredicate([](int, DocumentStatus, int) { return true; }),
+            corpus.size(), RetrievalStrategy::EXHAUSTIVE, &parallel_stats);
+        QueryStats rejected_stats;
+        search_server.FindTopDocuments(query, reject_all, corpus.size(), RetrievalStrategy::EXHAUSTIVE, &rejected_stats);
+        if constexpr (!QUERY_STATS_ENABLED) {
+            Check(stats.postings_scanned == 0 && stats.documents_scored == 0 && stats.total_ns == 0,
+                context + ": statistics collected without QUERY_STATS_ENABLED"s);
+            continue;
+        }
+        // перебор оценивает и предлагает выдаче каждый найденный документ
+        Check(stats.documents_scored == documents.size() && stats.candidates_sorted == documents.size(),
+            context + ": scored "s + to_string(stats.documents_scored) + " of "s + to_string(documents.size()));
+        Check(stats.postings_scanned >= documents.size(), context + ": too few postings scanned"s);
+        Check(stats.total_ns >= stats.parse_ns && stats.total_ns >= stats.selection_ns, context + ": wrong stage times"s);
+        Check(parallel_stats.postings_scanned == stats.postings_scanned
+            && parallel_stats.documents_scored == stats.documents_scored
+            && parallel_stats.filtered_by_minus_words == stats.filtered_by_minus_words,
+            context + ": parallel counters differ"s);
+        Check(rejected_stats.documents_scored == 0 && rejected_stats.filtered_by_predicate >= documents.size(),
+            context + ": filtered documents are scored"s);
+        filtered_by_minus_words += stats.filtered_by_minus_words;
+    }
+    if constexpr (QUERY_STATS_ENABLED) {
+        Check(filtered_by_minus_words > 0, "minus words filtered nothing"s);
+    }
+}
+
+// копии сервера пишут в общие гистограммы
+void TestQueryHistograms() {
+    CorpusGenerator generator(17);
+    const Corpus corpus = MakeCorpus(generator, 0, 500);
+    const vector<string> queries = generator.MakeQueries(20);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    search_server.ClearQueryHistograms();
+    const SearchServer copy = search_server;
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(query);
+        copy.FindTopDocuments(execution::par, query);
+    }
+    const QueryHistograms& histograms = search_server.GetQueryHistograms();
+    const uint64_t expected = QUERY_STATS_ENABLED ? queries.size() * 2 : 0;
+    Check(histograms.total_ns.GetCount() == expected && histograms.postings_scanned.GetCount() == expected
+        && histograms.documents_scored.GetCount() == expected && histograms.candidates_sorted.GetCount() == expected,
+        "histograms counted "s + to_string(histograms.total_ns.GetCount()) + " of "s + to_string(expected) + " queries"s);
+    search_server.ClearQueryHistograms();
+    Check(copy.GetQueryHistograms().total_ns.GetCount() == 0, "histograms are not cleared"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestLog2Histogram);
+    RUN_TEST(TestQueryStats);
+    RUN_TEST(TestQueryHistograms);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// Проверка удаления документов: по одному (последовательно и параллельно)
+// и пакетом. До очистки удалённые документы не находятся, но входят в IDF,
+// поэтому выдача сверяется с перебором того же сервера; после очистки -
+// с сервером, построенным заново.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server remove_documents_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o remove_documents_test -ltbb -lpthread
+#include <execution>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+void TestRemovalAndPurge() {
+    CorpusGenerator generator(4);
+    Corpus corpus = MakeCorpus(generator, 0, 4000);
+    const vector<string> queries = generator.MakeQueries(25);
+    SearchServer search_server = BuildReference(corpus, RankingModel::BM25);
+
+    vector<int> removed;
+    for (int id = 0; id < 4000; id += 5) {
+        removed.push_back(id);
+    }
+    // неизвестные и повторные id пропускаются
+    vector<int> batch = removed;
+    batch.insert(batch.end(), { 10, 20, 5000, 123456 });
+    search_server.RemoveDocuments(batch);
+    for (int id = 1; id < 4000; id += 13) {
+        if (id % 2 == 0) {
+            search_server.RemoveDocument(execution::par, id);
+        }
+        else {
+            search_server.RemoveDocument(execution::seq, id);
+        }
+        removed.push_back(id);
+    }
+    for (const int id : removed) {
+        corpus.erase(id);
+        CheckDocumentAbsent(search_server, id, "removed "s + to_string(id));
+    }
+    Check(search_server.GetDocumentCount() == static_cast<int>(corpus.size()), "document count before purge"s);
+    for (const string& query : queries) {
+        for (const RetrievalStrategy strategy : ALL_STRATEGIES) {
+            for (const DocumentStatus status : ALL_STATUSES) {
+                const vector<Document> expected = search_server.FindTopDocuments(query,
+                    PlainPredicate([status](int, DocumentStatus document_status, int) { return document_status == status; }));
+                const vector<Document> actual = search_server.FindTopDocuments(execution::par, query, status,
+                    MAX_RESULT_DOCUMENT_COUNT, strategy);
+                CheckSameDocuments(actual, expected, "before purge ["s + query + "]"s);
+                for (const Document& document : actual) {
+                    Check(corpus.count(document.id) > 0, "before purge: removed document found"s);
+                }
+            }
+        }
+    }
+
+    search_server.PurgeRemovedDocuments();
+    Check(search_server.GetDocumentCount() == static_cast<int>(corpus.size()), "document count after purge"s);
+    const SearchServer reference = BuildReference(corpus, RankingModel::BM25);
+    CheckAllSearchModes(search_server, reference, queries, "after purge"s);
+    CheckMatches(search_server, reference, corpus, queries, "after purge"s);
+
+    // номера удалённых документов переиспользуются
+    const Corpus added = MakeCorpus(generator, 4000, 500);
+    AddCorpus(search_server, added);
+    corpus.insert(added.begin(), added.end());
+    CheckAllSearchModes(search_server, BuildReference(corpus, RankingModel::BM25), queries, "after reuse"s);
+}
+
+// после удаления всех документов сервер пуст, но принимает новые
+void TestRemoveEverything() {
+    CorpusGenerator generator(15);
+    const Corpus corpus = MakeCorpus(generator, 0, 1000);
+    const vector<string> queries = generator.MakeQueries(10);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    vector<int> ids;
+    for (const auto& [id, document] : corpus) {
+        ids.push_back(id);
+    }
+    search_server.RemoveDocuments(ids);
+    search_server.PurgeRemovedDocuments();
+    Check(search_server.GetDocumentCount() == 0, "documents left after removing everything"s);
+    for (const string& query : queries) {
+        Check(search_server.FindTopDocuments(query).empty(), "empty server found ["s + query + "]"s);
+    }
+
+    const Corpus added = MakeCorpus(generator, 1000, 300);
+    AddCorpus(search_server, added);
+    CheckAllSearchModes(search_server, BuildReference(added, RankingModel::TF_IDF), queries, "refilled"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestRemovalAndPurge);
+    RUN_TEST(TestRemoveEverything);
+    return passed ? 0 : 1;
+}
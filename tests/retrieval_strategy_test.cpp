@@ -0,0 +1,94 @@
+// Проверка отсечения при поиске лучших документов: WAND и Block-Max WAND
+// выдают то же, что и полный перебор, при обеих моделях оценки, после
+// удалений (наибольшие частоты блоков тогда завышены), смены статусов
+// и добавления документов не по возрастанию id, а оценивают меньше
+// документов, чем перебор.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server retrieval_strategy_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o retrieval_strategy_test -ltbb -lpthread
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "query_stats.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+void TestStrategiesMatchExhaustive() {
+    CorpusGenerator generator(3);
+    const Corpus corpus = MakeCorpus(generator, 0, 6000);
+    const vector<string> queries = generator.MakeQueries(40);
+    for (const RankingModel model : { RankingModel::TF_IDF, RankingModel::BM25 }) {
+        const SearchServer search_server = BuildReference(corpus, model);
+        CheckAllSearchModes(search_server, search_server, queries, "built"s);
+    }
+}
+
+void TestStrategiesAfterChanges() {
+    CorpusGenerator generator(13);
+    // поздние id добавляются первыми, ранние копятся в буферах списков
+    Corpus corpus = MakeCorpus(generator, 3000, 3000);
+    const Corpus early = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(30);
+    for (const RankingModel model : { RankingModel::TF_IDF, RankingModel::BM25 }) {
+        Corpus changed = corpus;
+        SearchServer search_server = BuildReference(changed, model);
+        AddCorpus(search_server, early);
+        changed.insert(early.begin(), early.end());
+        for (int id = 0; id < 6000; id += 4) {
+            search_server.RemoveDocument(id);
+            changed.erase(id);
+        }
+        for (int id = 1; id < 6000; id += 9) {
+            if (changed.count(id) == 0) {
+                continue;
+            }
+            changed[id].status = generator.MakeStatus();
+            search_server.SetDocumentStatus(id, changed[id].status);
+        }
+        CheckAllSearchModes(search_server, BuildReference(changed, model), queries, "after changes"s);
+    }
+}
+
+void TestPruningSkipsDocuments() {
+    if constexpr (!QUERY_STATS_ENABLED) {
+        return;
+    }
+    CorpusGenerator generator(14);
+    const Corpus corpus = MakeCorpus(generator, 0, 20000);
+    const vector<string> queries = generator.MakeQueries(40);
+    const SearchServer search_server = BuildReference(corpus, RankingModel::BM25);
+    uint64_t exhaustive_scored = 0;
+    for (const RetrievalStrategy strategy : ALL_STRATEGIES) {
+        uint64_t scored = 0;
+        for (const string& query : queries) {
+            QueryStats stats;
+            search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10, strategy, &stats);
+            scored += stats.documents_scored;
+        }
+        if (strategy == RetrievalStrategy::EXHAUSTIVE) {
+            exhaustive_scored = scored;
+        }
+        else {
+            Check(scored < exhaustive_scored, "strategy "s + to_string(static_cast<int>(strategy)) + " scored "s
+                + to_string(scored) + " documents, exhaustive "s + to_string(exhaustive_scored));
+        }
+    }
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestStrategiesMatchExhaustive);
+    RUN_TEST(TestStrategiesAfterChanges);
+    RUN_TEST(TestPruningSkipsDocuments);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// Проверка равносильности индекса определению: FindTopDocuments,
+// MatchDocument и GetWordFrequencies сверяются с прямым подсчётом
+// по текстам документов, в том числе после удаления документов.
+// Корпус случайный, но с постоянным зерном; при ошибке выводится запрос.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server search_server_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o search_server_test -ltbb -lpthread
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+// слова MatchDocument и словарь GetWordFrequencies совпадают с определением
+void CheckDocumentsMatchDefinition(const SearchServer& search_server, const Corpus& corpus,
+    const DefinitionScorer& scorer, const vector<string>& queries, const string& context) {
+    for (const auto& [id, document] : corpus) {
+        const map<string, double> expected_freqs = scorer.GetWordFrequencies(id);
+        const map<string_view, double>& freqs = search_server.GetWordFrequencies(id);
+        bool same = freqs.size() == expected_freqs.size();
+        auto expected = expected_freqs.begin();
+        for (auto it = freqs.begin(); same && it != freqs.end(); ++it, ++expected) {
+            same = it->first == expected->first && abs(it->second - expected->second) <= RELEVANCE_TOLERANCE;
+        }
+        Check(same, context + ": GetWordFrequencies of document "s + to_string(id));
+
+        for (const string& query : queries) {
+            const auto [words, status] = search_server.MatchDocument(query, id);
+            const vector<string> expected = scorer.Match(query, id);
+            Check(vector<string>(words.begin(), words.end()) == expected && status == document.status,
+                context + " ["s + query + "]: MatchDocument of document "s + to_string(id));
+        }
+    }
+}
+
+void CheckTopDocumentsMatchDefinition(const SearchServer& search_server, const DefinitionScorer& scorer,
+    const vector<string>& queries, const string& context) {
+    for (const string& query : queries) {
+        for (const size_t max_count : MAX_COUNTS) {
+            ForEachPredicate([&](const string& name, const auto&, const PlainPredicate& plain_predicate) {
+                scorer.CheckTopDocuments(search_server.FindTopDocuments(query, plain_predicate, max_count), query,
+                    RankingModel::TF_IDF, plain_predicate, max_count, context + " ["s + query + "] "s + name);
+            });
+        }
+    }
+}
+
+// Перебор заново построенного сервера совпадает с подсчётом по определению,
+// остальные проверки опираются на него.
+void TestExhaustiveMatchesDefinition() {
+    CorpusGenerator generator(1);
+    const Corpus corpus = MakeCorpus(generator, 0, 2000);
+    const vector<string> queries = generator.MakeQueries(100);
+    const DefinitionScorer scorer(corpus);
+    CheckTopDocumentsMatchDefinition(BuildReference(corpus, RankingModel::TF_IDF), scorer, queries, "built"s);
+}
+
+void TestDocumentWordsMatchDefinition() {
+    CorpusGenerator generator(9);
+    const Corpus corpus = MakeCorpus(generator, 0, 500);
+    const vector<string> queries = generator.MakeQueries(20);
+    CheckDocumentsMatchDefinition(BuildReference(corpus, RankingModel::TF_IDF), corpus, DefinitionScorer(corpus),
+        queries, "built"s);
+}
+
+// RemoveDocument сразу убирает вхождения: выдача и слова оставшихся
+// документов такие же, как у сервера без удалённых документов
+void TestRemoveDocumentMatchesDefinition() {
+    CorpusGenerator generator(10);
+    Corpus corpus = MakeCorpus(generator, 0, 2000);
+    const vector<string> queries = generator.MakeQueries(40);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    for (int id = 0; id < 2000; id += 3) {
+        search_server.RemoveDocument(id);
+        corpus.erase(id);
+        CheckDocumentAbsent(search_server, id, "removed "s + to_string(id));
+    }
+    Check(search_server.GetDocumentCount() == static_cast<int>(corpus.size()), "document count after removal"s);
+    const DefinitionScorer scorer(corpus);
+    CheckTopDocumentsMatchDefinition(search_server, scorer, queries, "after removal"s);
+    CheckDocumentsMatchDefinition(search_server, corpus, scorer, vector<string>(queries.begin(), queries.begin() + 10),
+        "after removal"s);
+
+    // номера удалённых документов переиспользуются
+    const Corpus added = MakeCorpus(generator, 2000, 700);
+    AddCorpus(search_server, added);
+    corpus.insert(added.begin(), added.end());
+    CheckTopDocumentsMatchDefinition(search_server, DefinitionScorer(corpus), queries, "after reuse"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestExhaustiveMatchesDefinition);
+    RUN_TEST(TestDocumentWordsMatchDefinition);
+    RUN_TEST(TestRemoveDocumentMatchesDefinition);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+// Проверка ShardedSearchServer: выдача с любым фильтром и MatchDocument
+// совпадают с одним сервером на тех же документах, в том числе после
+// удаления документов и смены статуса, при обеих моделях оценки.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server sharded_search_server_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       ../search-server/sharded_search_server.cpp
+//       -o sharded_search_server_test -ltbb -lpthread
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+// части оценивают документы по общей статистике коллекции, поэтому
+// выдача та же, что у одного сервера
+void TestShardedSearchServer() {
+    CorpusGenerator generator(6);
+    Corpus corpus = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(40);
+    for (const RankingModel model : { RankingModel::TF_IDF, RankingModel::BM25 }) {
+        ShardedSearchServer sharded(4, vector<string>{ "and"s, "with"s });
+        sharded.SetRankingModel(model);
+        for (const auto& [id, document] : corpus) {
+            sharded.AddDocument(id, document.text, document.status, { document.rating });
+        }
+        Corpus changed = corpus;
+        for (int id = 0; id < 3000; id += 6) {
+            sharded.RemoveDocument(id);
+            changed.erase(id);
+        }
+        for (int id = 1; id < 3000; id += 10) {
+            changed[id].status = generator.MakeStatus();
+            sharded.SetDocumentStatus(id, changed[id].status);
+        }
+        const SearchServer reference = BuildReference(changed, model);
+        Check(sharded.GetDocumentCount() == reference.GetDocumentCount(), "sharded document count"s);
+        for (const string& query : queries) {
+            const string where = "sharded ["s + query + "]"s;
+            ForEachPredicate([&](const string& name, const auto& predicate, const PlainPredicate& plain_predicate) {
+                CheckSameDocuments(sharded.FindTopDocuments(query, predicate, 10),
+                    reference.FindTopDocuments(query, plain_predicate, 10), where + " "s + name);
+            });
+            CheckSameDocuments(sharded.FindTopDocuments(query), reference.FindTopDocuments(query), where);
+            for (int id = 1; id < 3000; id += 37) {
+                if (changed.count(id) == 0) {
+                    continue;
+                }
+                Check(sharded.MatchDocument(query, id) == reference.MatchDocument(query, id), where + " MatchDocument"s);
+            }
+        }
+    }
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestShardedSearchServer);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Проверка списков вхождений, разделённых по статусу: после смены статусов
+// SetDocumentStatus поиск и MatchDocument те же, что у сервера, заново
+// построенного с новыми статусами, в том числе у открытого сохранённого
+// индекса, чьи вхождения лежат неразделённой частью.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server status_postings_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o status_postings_test -ltbb -lpthread
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+// count смен статуса случайных документов, в том числе на тот же статус
+void ChangeStatuses(SearchServer& search_server, Corpus& corpus, CorpusGenerator& generator, int count, int id_bound) {
+    for (int i = 0; i < count; ++i) {
+        const auto it = corpus.find(generator.MakeIndex(id_bound));
+        if (it != corpus.end()) {
+            it->second.status = generator.MakeStatus();
+            search_server.SetDocumentStatus(it->first, it->second.status);
+        }
+    }
+}
+
+void TestSetDocumentStatusMatchesRebuilt() {
+    CorpusGenerator generator(20);
+    const vector<string> queries = generator.MakeQueries(30);
+    for (const RankingModel model : { RankingModel::TF_IDF, RankingModel::BM25 }) {
+        Corpus corpus = MakeCorpus(generator, 0, 4000);
+        SearchServer search_server = BuildReference(corpus, model);
+        ChangeStatuses(search_server, corpus, generator, 3000, 4000);
+        const SearchServer reference = BuildReference(corpus, model);
+        CheckAllSearchModes(search_server, reference, queries, "after SetDocumentStatus"s);
+        CheckMatches(search_server, reference, corpus, vector<string>(queries.begin(), queries.begin() + 5),
+            "after SetDocumentStatus"s);
+    }
+
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "w1 w2"s, DocumentStatus::ACTUAL, { 1 });
+    bool thrown = false;
+    try {
+        search_server.SetDocumentStatus(2, DocumentStatus::BANNED);
+    }
+    catch (const out_of_range&) {
+        thrown = true;
+    }
+    Check(thrown, "status of unknown document is changed"s);
+}
+
+// смена статусов, пока вхождения документов, удалённых пакетом, ещё в списках
+void TestSetDocumentStatusWithRemovals() {
+    CorpusGenerator generator(21);
+    Corpus corpus = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(20);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+    vector<int> removed;
+    for (int id = 0; id < 3000; id += 4) {
+        removed.push_back(id);
+        corpus.erase(id);
+    }
+    search_server.RemoveDocuments(removed);
+    ChangeStatuses(search_server, corpus, generator, 1500, 3000);
+    search_server.PurgeRemovedDocuments();
+    CheckAllSearchModes(search_server, BuildReference(corpus, RankingModel::TF_IDF), queries, "after purge"s);
+}
+
+void TestSetDocumentStatusOnOpenedIndex() {
+    CorpusGenerator generator(22);
+    Corpus corpus = MakeCorpus(generator, 0, 3000);
+    const vector<string> queries = generator.MakeQueries(20);
+    const string path = (filesystem::temp_directory_path() / "status_postings_test.index"s).string();
+    BuildReference(corpus, RankingModel::TF_IDF).SaveIndex(path);
+    {
+        SearchServer search_server = SearchServer::OpenIndex(path);
+        ChangeStatuses(search_server, corpus, generator, 1000, 3000);
+        CheckAllSearchModes(search_server, BuildReference(corpus, RankingModel::TF_IDF), queries, "opened"s);
+
+        // новые документы ложатся в части своих статусов рядом с неразделённой
+        const Corpus added = MakeCorpus(generator, 3000, 500);
+        AddCorpus(search_server, added);
+        corpus.insert(added.begin(), added.end());
+        ChangeStatuses(search_server, corpus, generator, 1000, 3500);
+        const SearchServer reference = BuildReference(corpus, RankingModel::TF_IDF);
+        CheckAllSearchModes(search_server, reference, queries, "opened and changed"s);
+        CheckMatches(search_server, reference, corpus, vector<string>(queries.begin(), queries.begin() + 5),
+            "opened and changed"s);
+    }
+    filesystem::remove(path);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestSetDocumentStatusMatchesRebuilt);
+    RUN_TEST(TestSetDocumentStatusWithRemovals);
+    RUN_TEST(TestSetDocumentStatusOnOpenedIndex);
+    return passed ? 0 : 1;
+}
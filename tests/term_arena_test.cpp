@@ -0,0 +1,78 @@
+// Проверка хранения слов в арене: уплотнение после массовых удалений
+// не портит слова, уже выданные для живых документов, а поиск после
+// уплотнения совпадает с сервером, построенным заново.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server term_arena_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       -o term_arena_test -ltbb -lpthread
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+
+using namespace std;
+
+// Удаление документов с уникальными словами запускает уплотнение
+// (SearchServer::CompactTerms) несколько раз подряд.
+void AddAndRemoveUniqueWords(SearchServer& search_server, int first_id, int count) {
+    for (int id = first_id; id < first_id + count; ++id) {
+        search_server.AddDocument(id, "unique"s + to_string(id) + " other"s + to_string(id), DocumentStatus::ACTUAL, { 1 });
+    }
+    for (int id = first_id; id < first_id + count; ++id) {
+        search_server.RemoveDocument(id);
+    }
+}
+
+void TestWordsSurviveCompaction() {
+    CorpusGenerator generator(12);
+    const Corpus corpus = MakeCorpus(generator, 0, 300);
+    const vector<string> queries = generator.MakeQueries(20);
+    SearchServer search_server = BuildReference(corpus, RankingModel::TF_IDF);
+
+    // ссылки на выданные слова и их копии для сравнения
+    vector<const map<string_view, double>*> freqs;
+    vector<map<string, double>> expected_freqs;
+    vector<vector<string_view>> words;
+    vector<vector<string>> expected_words;
+    for (const auto& [id, document] : corpus) {
+        freqs.push_back(&search_server.GetWordFrequencies(id));
+        expected_freqs.emplace_back(freqs.back()->begin(), freqs.back()->end());
+        words.push_back(search_server.GetDocumentWords(id));
+        expected_words.emplace_back(words.back().begin(), words.back().end());
+    }
+
+    AddAndRemoveUniqueWords(search_server, 10000, 5000);
+    // слова, выданные между уплотнениями, лежат в промежуточной арене
+    const auto [middle_words, status] = search_server.MatchDocument(queries[0], 0);
+    const vector<string> expected_middle_words(middle_words.begin(), middle_words.end());
+    AddAndRemoveUniqueWords(search_server, 20000, 5000);
+
+    size_t index = 0;
+    for (const auto& [id, document] : corpus) {
+        Check(map<string, double>(freqs[index]->begin(), freqs[index]->end()) == expected_freqs[index],
+            "GetWordFrequencies of document "s + to_string(id) + " changed after compaction"s);
+        Check(vector<string>(words[index].begin(), words[index].end()) == expected_words[index],
+            "GetDocumentWords of document "s + to_string(id) + " changed after compaction"s);
+        ++index;
+    }
+    Check(vector<string>(middle_words.begin(), middle_words.end()) == expected_middle_words,
+        "MatchDocument words changed after compaction"s);
+
+    CheckAllSearchModes(search_server, BuildReference(corpus, RankingModel::TF_IDF), queries, "after compaction"s);
+    CheckMatches(search_server, BuildReference(corpus, RankingModel::TF_IDF), corpus, queries, "after compaction"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestWordsSurviveCompaction);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,404 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "search_server.h"
+
+// Общие средства проверок: случайный корпус с постоянным зерном, прямой
+// подсчёт TF-IDF и BM25 по текстам документов и сверка выдачи сервера
+// с полным перебором (RetrievalStrategy::EXHAUSTIVE) на сервере,
+// заново построенном по тем же документам. При ошибке проверка бросает
+// runtime_error с запросом и обеими выдачами.
+
+inline const string STOP_WORDS = "and with"s;
+// расхождение релевантности из-за порядка сложения вкладов
+inline const double RELEVANCE_TOLERANCE = 1e-9;
+
+inline const RetrievalStrategy ALL_STRATEGIES[] = {
+    RetrievalStrategy::EXHAUSTIVE,
+    RetrievalStrategy::WAND,
+    RetrievalStrategy::BLOCK_MAX_WAND,
+};
+inline const DocumentStatus ALL_STATUSES[] = {
+    DocumentStatus::ACTUAL,
+    DocumentStatus::IRRELEVANT,
+    DocumentStatus::BANNED,
+    DocumentStatus::REMOVED,
+};
+inline const size_t MAX_COUNTS[] = { 1, 5, 40 };
+
+inline void Check(bool condition, const string& message) {
+    if (!condition) {
+        throw runtime_error(message);
+    }
+}
+
+struct ModelDocument {
+    string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    int rating = 0;
+};
+
+// документы, которые должны быть в сервере, по id
+using Corpus = map<int, ModelDocument>;
+
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(uint32_t seed)
+        : random_(seed) {
+    }
+
+    // частые слова с малыми номерами дают длинные списки вхождений
+    string MakeWord() {
+        const double u = uniform_real_distribution<double>(0.0, 1.0)(random_);
+        return "w"s + to_string(static_cast<int>(VOCABULARY_SIZE * u * u * u));
+    }
+
+    ModelDocument MakeDocument() {
+        ModelDocument document;
+        const int length = uniform_int_distribution<int>(1, 30)(random_);
+        for (int i = 0; i < length; ++i) {
+            document.text += MakeWord() + " "s;
+            if (random_() % 8 == 0) {
+                document.text += "and "s;
+            }
+        }
+        document.status = MakeStatus();
+        document.rating = uniform_int_distribution<int>(-10, 10)(random_);
+        return document;
+    }
+
+    DocumentStatus MakeStatus() {
+        // большинство документов актуальны, как в настоящем индексе
+        return random_() % 4 != 0 ? DocumentStatus::ACTUAL : ALL_STATUSES[random_() % 4];
+    }
+
+    string MakeQuery() {
+        string query;
+        const int plus_count = uniform_int_distribution<int>(1, 4)(random_);
+        for (int i = 0; i < plus_count; ++i) {
+            query += MakeWord() + " "s;
+        }
+        if (random_() % 3 == 0) {
+            query += "-"s + MakeWord() + " "s;
+        }
+        if (random_() % 10 == 0) {
+            query += "with absent "s;
+        }
+        return query;
+    }
+
+    vector<string> MakeQueries(size_t count) {
+        vector<string> queries(count);
+        for (string& query : queries) {
+            query = MakeQuery();
+        }
+        return queries;
+    }
+
+    int MakeIndex(int count) {
+        return static_cast<int>(random_() % count);
+    }
+
+private:
+    static constexpr int VOCABULARY_SIZE = 400;
+
+    mt19937 random_;
+};
+
+inline Corpus MakeCorpus(CorpusGenerator& generator, int first_id, int count) {
+    Corpus corpus;
+    for (int id = first_id; id < first_id + count; ++id) {
+        corpus[id] = generator.MakeDocument();
+    }
+    return corpus;
+}
+
+inline void AddCorpus(SearchServer& search_server, const Corpus& corpus) {
+    for (const auto& [id, document] : corpus) {
+        search_server.AddDocument(id, document.text, document.status, { document.rating });
+    }
+}
+
+inline SearchServer BuildReference(const Corpus& corpus, RankingModel model) {
+    SearchServer search_server(STOP_WORDS);
+    search_server.SetRankingModel(model);
+    AddCorpus(search_server, corpus);
+    return search_server;
+}
+
+inline string Describe(const vector<Document>& documents) {
+    ostringstream out;
+    for (const Document& document : documents) {
+        out << document << ' ';
+    }
+    return out.str();
+}
+
+inline void CheckSameDocuments(const vector<Document>& actual, const vector<Document>& expected, const string& context) {
+    bool same = actual.size() == expected.size();
+    for (size_t i = 0; same && i < actual.size(); ++i) {
+        same = actual[i].id == expected[i].id && actual[i].rating == expected[i].rating
+            && abs(actual[i].relevance - expected[i].relevance) <= RELEVANCE_TOLERANCE;
+    }
+    Check(same, context + "\n  actual:   "s + Describe(actual) + "\n  expected: "s + Describe(expected));
+}
+
+using PlainPredicate = function<bool(int, DocumentStatus, int)>;
+
+// predicate_func(name, predicate, plain_predicate) для каждого вида фильтра:
+// predicate проверяется сервером, plain_predicate - тот же отбор обычной
+// функцией, которую сервер вызывает для каждого документа
+template <typename PredicateFunc>
+void ForEachPredicate(PredicateFunc predicate_func) {
+    for (const DocumentStatus status : ALL_STATUSES) {
+        predicate_func("StatusFilter"s, StatusFilter{ status }, PlainPredicate([status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+            }));
+    }
+    predicate_func("RatingFilter"s, RatingFilter{ -3, 4 }, PlainPredicate([](int, DocumentStatus, int rating) {
+        return -3 <= rating && rating <= 4;
+        }));
+    vector<int> ids;
+    for (int id = 0; id < 100000; id += 7) {
+        ids.push_back(id);
+    }
+    predicate_func("DocumentIdFilter"s, DocumentIdFilter(ids), PlainPredicate([](int document_id, DocumentStatus, int) {
+        return document_id % 7 == 0;
+        }));
+    const auto lambda = [](int document_id, DocumentStatus status, int rating) {
+        return document_id % 3 != 0 && status != DocumentStatus::BANNED && rating > -5;
+    };
+    predicate_func("lambda"s, lambda, PlainPredicate(lambda));
+}
+
+// Прямой подсчёт по текстам: все документы, прошедшие отбор, со словами
+// запроса и без его минус-слов, с релевантностью по формулам из ranking.h.
+// N и средняя длина считаются по всем документам корпуса.
+// Там же слова запроса в документе и частоты слов документа.
+class DefinitionScorer {
+public:
+    explicit DefinitionScorer(const Corpus& corpus)
+        : corpus_(corpus) {
+        int64_t total_length = 0;
+        for (const auto& [id, document] : corpus) {
+            const vector<string> words = SplitWithoutStopWords(document.text);
+            lengths_[id] = static_cast<int>(words.size());
+            total_length += words.size();
+            for (const string& word : words) {
+                if (word_counts_[id][word]++ == 0) {
+                    ++document_freqs_[word];
+                }
+            }
+        }
+        average_length_ = total_length * 1.0 / corpus.size();
+    }
+
+    vector<Document> Score(const string& raw_query, RankingModel model, const PlainPredicate& predicate,
+        const Bm25Params& params = {}) const {
+        const auto [plus_words, minus_words] = ParseQuery(raw_query);
+        const double document_count = static_cast<double>(corpus_.size());
+        vector<Document> result;
+        for (const auto& [id, document] : corpus_) {
+            const map<string, int>& counts = word_counts_.at(id);
+            if (!predicate(id, document.status, document.rating)
+                || any_of(minus_words.begin(), minus_words.end(), [&](const string& word) { return counts.count(word) > 0; })) {
+                continue;
+            }
+            bool matched = false;
+            double relevance = 0.0;
+            for (const string& word : plus_words) {
+                const auto it = counts.find(word);
+                if (it == counts.end()) {
+                    continue;
+                }
+                matched = true;
+                const double count = it->second;
+                const double length = lengths_.at(id);
+                const double document_freq = document_freqs_.at(word);
+                if (model == RankingModel::TF_IDF) {
+                    relevance += count / length * log(document_count / document_freq);
+                }
+                else {
+                    const double idf = log(1.0 + (document_count - document_freq + 0.5) / (document_freq + 0.5));
+                    relevance += idf * count * (params.k1 + 1.0)
+                        / (count + params.k1 * (1.0 - params.b + params.b * length / average_length_));
+                }
+            }
+            if (matched) {
+                result.push_back({ id, relevance, document.rating });
+            }
+        }
+        return result;
+    }
+
+    // плюс-слова запроса из документа по алфавиту, пусто при минус-слове
+    vector<string> Match(const string& raw_query, int document_id) const {
+        const auto [plus_words, minus_words] = ParseQuery(raw_query);
+        const map<string, int>& counts = word_counts_.at(document_id);
+        vector<string> words;
+        if (any_of(minus_words.begin(), minus_words.end(), [&](const string& word) { return counts.count(word) > 0; })) {
+            return words;
+        }
+        copy_if(plus_words.begin(), plus_words.end(), back_inserter(words), [&](const string& word) {
+            return counts.count(word) > 0;
+            });
+        return words;
+    }
+
+    // доля каждого слова среди слов документа
+    map<string, double> GetWordFrequencies(int document_id) const {
+        map<string, double> freqs;
+        for (const auto& [word, count] : word_counts_.at(document_id)) {
+            freqs[word] = count * 1.0 / lengths_.at(document_id);
+        }
+        return freqs;
+    }
+
+    // выдача - лучшие max_count документов прямого подсчёта с его релевантностью
+    void CheckTopDocuments(const vector<Document>& documents, const string& raw_query, RankingModel model,
+        const PlainPredicate& predicate, size_t max_count, const string& context, const Bm25Params& params = {}) const {
+        const vector<Document> all = Score(raw_query, model, predicate, params);
+        Check(documents.size() == min(max_count, all.size()), context + ": wrong document count"s);
+        map<int, double> relevances;
+        for (const Document& document : all) {
+            relevances[document.id] = document.relevance;
+        }
+        for (const Document& document : documents) {
+            const auto it = relevances.find(document.id);
+            Check(it != relevances.end(), context + ": unexpected document "s + to_string(document.id));
+            Check(abs(it->second - document.relevance) <= RELEVANCE_TOLERANCE,
+                context + ": wrong relevance of document "s + to_string(document.id));
+            relevances.erase(it);
+        }
+        if (!documents.empty()) {
+            // ни один пропущенный документ не лучше последнего в выдаче
+            for (const auto& [id, relevance] : relevances) {
+                Check(relevance <= documents.back().relevance + VALUE, context + ": missed document "s + to_string(id));
+            }
+        }
+    }
+
+private:
+    // плюс-слова без повторов по алфавиту и минус-слова
+    static pair<vector<string>, vector<string>> ParseQuery(const string& raw_query) {
+        vector<string> plus_words;
+        vector<string> minus_words;
+        for (const string& word : SplitWithoutStopWords(raw_query)) {
+            if (word[0] == '-') {
+                minus_words.push_back(word.substr(1));
+            }
+            else {
+                plus_words.push_back(word);
+            }
+        }
+        sort(plus_words.begin(), plus_words.end());
+        plus_words.erase(unique(plus_words.begin(), plus_words.end()), plus_words.end());
+        return { plus_words, minus_words };
+    }
+
+    static vector<string> SplitWithoutStopWords(const string& text) {
+        vector<string> words;
+        istringstream in(text);
+        for (string word; in >> word;) {
+            if (word != "and"s && word != "with"s) {
+                words.push_back(word);
+            }
+        }
+        return words;
+    }
+
+    const Corpus& corpus_;
+    map<int, map<string, int>> word_counts_;
+    map<int, int> lengths_;
+    map<string, int> document_freqs_;
+    double average_length_ = 0.0;
+};
+
+// Выдача всех стратегий, режимов и фильтров search_server совпадает
+// с перебором на reference с обычной функцией отбора.
+inline void CheckAllSearchModes(const SearchServer& search_server, const SearchServer& reference,
+    const vector<string>& queries, const string& context) {
+    for (const string& query : queries) {
+        for (const size_t max_count : MAX_COUNTS) {
+            ForEachPredicate([&](const string& name, const auto& predicate, const PlainPredicate& plain_predicate) {
+                const vector<Document> expected = reference.FindTopDocuments(query, plain_predicate, max_count);
+                for (const RetrievalStrategy strategy : ALL_STRATEGIES) {
+                    const string where = context + " ["s + query + "] "s + name + " strategy "s
+                        + to_string(static_cast<int>(strategy)) + " max_count "s + to_string(max_count);
+                    CheckSameDocuments(search_server.FindTopDocuments(execution::seq, query, predicate, max_count, strategy),
+                        expected, where + " seq"s);
+                    CheckSameDocuments(search_server.FindTopDocuments(execution::par, query, predicate, max_count, strategy),
+                        expected, where + " par"s);
+                }
+            });
+            for (const DocumentStatus status : ALL_STATUSES) {
+                const vector<Document> expected = reference.FindTopDocuments(query,
+                    PlainPredicate([status](int, DocumentStatus document_status, int) { return document_status == status; }),
+                    max_count);
+                CheckSameDocuments(search_server.FindTopDocuments(query, status, max_count), expected,
+                    context + " ["s + query + "] status overload"s);
+            }
+        }
+        CheckSameDocuments(search_server.FindTopDocuments(execution::par, query), reference.FindTopDocuments(query),
+            context + " ["s + query + "] default"s);
+    }
+}
+
+// MatchDocument и MatchDocuments совпадают с reference для всех документов
+inline void CheckMatches(const SearchServer& search_server, const SearchServer& reference, const Corpus& corpus,
+    const vector<string>& queries, const string& context) {
+    vector<int> document_ids;
+    for (const auto& [id, document] : corpus) {
+        document_ids.push_back(id);
+    }
+    for (const string& query : queries) {
+        const auto matches = search_server.MatchDocuments(query, document_ids);
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const int id = document_ids[i];
+            const auto expected = reference.MatchDocument(query, id);
+            const string where = context + " ["s + query + "] document "s + to_string(id);
+            Check(search_server.MatchDocument(query, id) == expected, where + " seq"s);
+            Check(search_server.MatchDocument(execution::par, query, id) == expected, where + " par"s);
+            Check(matches[i] == expected, where + " MatchDocuments"s);
+            Check(get<1>(expected) == corpus.at(id).status, where + " status"s);
+        }
+    }
+}
+
+// запрос к удалённому документу бросает out_of_range
+inline void CheckDocumentAbsent(const SearchServer& search_server, int document_id, const string& context) {
+    Check(!search_server.HasDocument(document_id), context + ": removed document is still present"s);
+    bool thrown = false;
+    try {
+        search_server.MatchDocument("w0"s, document_id);
+    }
+    catch (const out_of_range&) {
+        thrown = true;
+    }
+    Check(thrown, context + ": MatchDocument of removed document did not throw"s);
+}
+
+template <typename TestFunc>
+bool RunTest(const string& name, TestFunc test) {
+    try {
+        test();
+        cerr << name << " OK"s << endl;
+        return true;
+    }
+    catch (const exception& e) {
+        cerr << name << " fail: "s << e.what() << endl;
+        return false;
+    }
+}
+
+#define RUN_TEST(func) passed = RunTest(#func, func) && passed
@@ -0,0 +1,85 @@
+// Проверка снимков VersionedSearchServer: опубликованный снимок не меняется
+// после следующих изменений, а новый снимок совпадает с сервером,
+// заново построенным по тем же документам.
+// Сборка из каталога tests (одной командой):
+//   g++ -std=c++17 -O2 -I../search-server versioned_search_server_test.cpp
+//       ../search-server/search_server.cpp ../search-server/string_processing.cpp
+//       ../search-server/document.cpp ../search-server/read_input_functions.cpp
+//       ../search-server/index_segment.cpp ../search-server/inverted_index.cpp
+//       ../search-server/posting_blocks.cpp ../search-server/term_arena.cpp
+//       ../search-server/ranking.cpp ../search-server/score_accumulator.cpp
+//       ../search-server/stop_word_set.cpp ../search-server/top_documents.cpp
+//       ../search-server/remove_duplicates.cpp ../search-server/duplicate_detector.cpp
+//       ../search-server/query_stats.cpp ../search-server/document_filter.cpp
+//       ../search-server/versioned_search_server.cpp
+//       -o versioned_search_server_test -ltbb -lpthread
+#include <memory>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_helpers.h"
+#include "versioned_search_server.h"
+
+using namespace std;
+
+void TestSnapshotsAreImmutable() {
+    CorpusGenerator generator(8);
+    const Corpus original = MakeCorpus(generator, 0, 2000);
+    const vector<string> queries = generator.MakeQueries(20);
+    VersionedSearchServer versioned(BuildReference(original, RankingModel::TF_IDF));
+    const shared_ptr<const SearchServer> old_snapshot = versioned.GetSnapshot();
+
+    Corpus corpus = original;
+    const Corpus added = MakeCorpus(generator, 2000, 300);
+    versioned.Update([&](SearchServer& search_server) {
+        AddCorpus(search_server, added);
+        });
+    corpus.insert(added.begin(), added.end());
+    for (int id = 0; id < 2300; id += 8) {
+        versioned.RemoveDocument(id);
+        corpus.erase(id);
+    }
+    versioned.SetDocumentStatus(1, DocumentStatus::IRRELEVANT);
+    corpus[1].status = DocumentStatus::IRRELEVANT;
+
+    CheckAllSearchModes(*versioned.GetSnapshot(), BuildReference(corpus, RankingModel::TF_IDF), queries, "new snapshot"s);
+    CheckAllSearchModes(*old_snapshot, BuildReference(original, RankingModel::TF_IDF), queries, "old snapshot"s);
+}
+
+// Длинные списки вхождений разделяются снимками по группам блоков:
+// изменения в середине и в хвосте списка не видны старому снимку.
+void TestSnapshotsShareLongPostingLists() {
+    CorpusGenerator generator(11);
+    // около 15000 вхождений common - несколько групп блоков
+    Corpus corpus = MakeCorpus(generator, 0, 30000);
+    for (auto& [id, document] : corpus) {
+        if (id % 2 == 0) {
+            document.text += "common "s;
+        }
+    }
+    const vector<string> queries = { "common"s, "common w1 -w2"s, "w0 w3"s };
+    VersionedSearchServer versioned(BuildReference(corpus, RankingModel::BM25));
+    const Corpus original = corpus;
+    const shared_ptr<const SearchServer> old_snapshot = versioned.GetSnapshot();
+
+    for (int id = 5000; id < 30000; id += 998) {
+        versioned.RemoveDocument(id);
+        corpus.erase(id);
+    }
+    Corpus added = MakeCorpus(generator, 30000, 200);
+    for (auto& [id, document] : added) {
+        document.text += id % 2 == 0 ? "common "s : ""s;
+        versioned.AddDocument(id, document.text, document.status, { document.rating });
+    }
+    corpus.insert(added.begin(), added.end());
+
+    CheckAllSearchModes(*versioned.GetSnapshot(), BuildReference(corpus, RankingModel::BM25), queries, "new snapshot"s);
+    CheckAllSearchModes(*old_snapshot, BuildReference(original, RankingModel::BM25), queries, "old snapshot"s);
+}
+
+int main() {
+    bool passed = true;
+    RUN_TEST(TestSnapshotsAreImmutable);
+    RUN_TEST(TestSnapshotsShareLongPostingLists);
+    return passed ? 0 : 1;
+}